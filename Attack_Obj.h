@@ -11,8 +11,8 @@ public:
 	virtual ~Attack_Obj() = default;
 	Attack_Obj(const Attack_Obj&) = default;
 
-	size_t GetRange() { return m_attack.m_range; }
-	double GetPHit() { return m_attack.m_pHit; }
+	size_t GetRange() const { return m_attack.m_range; }
+	double GetPHit() const { return m_attack.m_pHit; }
 
 private:
 	class Attack
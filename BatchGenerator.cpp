@@ -0,0 +1,164 @@
+#include "BatchGenerator.h"
+
+#include <iostream>
+#include <future>
+#include <memory>
+
+#include "POMDP_Writer.h"
+#include "PerseusSolver.h"
+
+BatchGenerator::BatchGenerator(size_t threads)
+: m_tables()
+, m_pool(threads > 0 ? threads : 1)
+{
+}
+
+std::vector<size_t> BatchGenerator::Generate(const std::vector<BatchScenario>& scenarios)
+{
+	std::vector<size_t> bytesWritten(scenarios.size(), 0);
+	std::vector<std::future<void>> done;
+	done.reserve(scenarios.size());
+	for (size_t i = 0; i < scenarios.size(); ++i)
+	{
+		done.push_back(m_pool.Submit([this, &scenarios, &bytesWritten, i]()
+		{
+			bytesWritten[i] = GenerateSingle(scenarios[i]);
+		}));
+	}
+
+	for (auto & d : done)
+	{
+		d.get();
+	}
+
+	return bytesWritten;
+}
+
+// a file that ends with .gz is compressed
+static bool IsCompressed(const std::string& fileName)
+{
+	static const std::string s_suffix = ".gz";
+	return fileName.size() > s_suffix.size() && 0 == fileName.compare(fileName.size() - s_suffix.size(), s_suffix.size(), s_suffix);
+}
+
+// solve the model of the writer with PerseusSolver (by the thread of the scenario)
+static void SolveSingle(POMDP_Writer& writer, const BatchScenario& scenario)
+{
+	// the error is of this scenario only (the other scenarios are still generated)
+	if (!PerseusSolver<float>::IsValidDiscount(scenario.m_discount))
+	{
+		std::cerr << "ERROR discount of " + scenario.m_fileName + " must be in [0, 1) to solve\n";
+		return;
+	}
+
+	std::string alphaName = scenario.m_fileName + ".alpha";
+	FILE *fptr = FileSink::Open(alphaName.c_str(), "w");
+	if (nullptr == fptr)
+	{
+		std::cerr << "ERROR OPEN " + alphaName + "\n";
+		return;
+	}
+
+	PomdpModel<float> model = writer.BuildModel<float>(scenario.m_idxTarget);
+	PerseusSolver<float> solver(model);
+	solver.SetBudget(100, scenario.m_solveSeconds);
+	solver.Solve();
+
+	FileSink sink(fptr);
+	bool isWritten = solver.GetAlphaVectors().WriteAlpha(sink);
+	if (fclose(fptr) != 0 || !isWritten)
+	{
+		std::cerr << "ERROR WRITE " + alphaName + "\n";
+	}
+}
+
+size_t BatchGenerator::GenerateSingle(const BatchScenario& scenario)
+{
+	// objects that are not valid states are an error of this scenario only (its file is not created)
+	size_t numObjects = 2 + scenario.m_nonInvolved.size();
+	if (!StateIndexer::IsValid(scenario.m_gridSize, numObjects))
+	{
+		std::cerr << "ERROR " + scenario.m_fileName + ": " + std::to_string(numObjects) + " objects in grid " + std::to_string(scenario.m_gridSize) + " are not valid states\n";
+		return 0;
+	}
+
+	bool isCompressed = IsCompressed(scenario.m_fileName);
+	FILE *fptr = FileSink::Open(scenario.m_fileName.c_str(), scenario.m_isBinary || isCompressed ? "wb" : "w");
+	if (nullptr == fptr)
+	{
+		std::cerr << "ERROR OPEN " + scenario.m_fileName + "\n";
+		return 0;
+	}
+
+	// the writer keeps copies of the objects (the objects of the scenario are not changed)
+	Self_Obj self(scenario.m_self);
+	Attack_Obj enemy(scenario.m_enemy);
+	POMDP_Writer writer(scenario.m_gridSize, self, enemy, scenario.m_discount);
+	for (auto obj : scenario.m_nonInvolved)
+	{
+		writer.AddObj(obj);
+	}
+	for (auto obj : scenario.m_shelters)
+	{
+		writer.AddObj(obj);
+	}
+	writer.SetGridTables(&m_tables);
+
+	// the scenarios run in parallel so each scenario is calculated (and compressed) by a single thread
+	FileSink fileSink(fptr);
+	std::unique_ptr<GzipSink> gzipSink(isCompressed ? new GzipSink(fileSink) : nullptr);
+	OutputSink& sink = isCompressed ? static_cast<OutputSink&>(*gzipSink) : fileSink;
+	// a failure is reported for this scenario only (the other scenarios are still generated)
+	size_t bytesWritten = 0;
+	std::string error = "Error Writing to file";
+	if (scenario.m_isBinary)
+	{
+		bytesWritten = writer.SaveBinary(sink, scenario.m_idxTarget);
+	}
+	else
+	{
+		GenerationStats stats = writer.SaveInFormat(sink, scenario.m_idxTarget);
+		bytesWritten = stats.IsFailed() ? 0 : stats.m_bytesWritten;
+		error = stats.IsFailed() ? stats.m_error : error;
+	}
+
+	// the index of the blocks of the compressed file is written to <file>.idx
+	if (isCompressed)
+	{
+		if (bytesWritten > 0 && !WriteIndex(*gzipSink, scenario.m_fileName + ".idx"))
+		{
+			bytesWritten = 0;
+			error = "Error Writing index";
+		}
+		gzipSink.reset();
+	}
+	if (fclose(fptr) != 0)
+	{
+		bytesWritten = 0;
+	}
+	if (0 == bytesWritten)
+	{
+		std::cerr << "ERROR " + scenario.m_fileName + ": " + error + "\n";
+		return 0;
+	}
+
+	if (scenario.m_solveSeconds > 0)
+	{
+		SolveSingle(writer, scenario);
+	}
+	return bytesWritten;
+}
+
+bool BatchGenerator::WriteIndex(const GzipSink& gzipSink, const std::string& indexName)
+{
+	FILE *fptr = FileSink::Open(indexName.c_str(), "w");
+	if (nullptr == fptr)
+	{
+		std::cerr << "ERROR OPEN " + indexName + "\n";
+		return false;
+	}
+
+	FileSink sink(fptr);
+	bool isWritten = gzipSink.WriteIndex(sink);
+	return fclose(fptr) == 0 && isWritten;
+}
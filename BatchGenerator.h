@@ -0,0 +1,60 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "Self_Obj.h"
+#include "Attack_Obj.h"
+#include "Movable_Obj.h"
+#include "ObjInGrid.h"
+#include "ThreadPool.h"
+#include "GridTables.h"
+#include "GzipSink.h"
+
+// description of a single scenario of the batch and the file it is written to
+struct BatchScenario
+{
+	BatchScenario(size_t gridSize, const Self_Obj& self, const Attack_Obj& enemy, size_t idxTarget, const std::string& fileName)
+		: m_gridSize(gridSize), m_self(self), m_enemy(enemy), m_idxTarget(idxTarget), m_fileName(fileName) {}
+
+	size_t m_gridSize;
+	Self_Obj m_self;
+	Attack_Obj m_enemy;
+	std::vector<Movable_Obj> m_nonInvolved;
+	std::vector<ObjInGrid> m_shelters;
+	size_t m_idxTarget;
+	double m_discount = 0.95;
+	// write the binary model instead of the pomdp format
+	bool m_isBinary = false;
+	// a file that ends with .gz is compressed (see GzipSink) and the index of its blocks is written to <file>.idx
+	std::string m_fileName;
+	// solve the model for at most the seconds after it is written and write the alpha vectors to <file>.alpha (0: no solve)
+	double m_solveSeconds = 0.0;
+};
+
+//	generates many scenarios concurrently on a single pool of workers (each scenario is written by a single worker
+//	with its own writer). the topology and the shots are shared between scenarios with the same grid.
+//	Generate can be called from several threads at once (but not from a task of the pool)
+class BatchGenerator
+{
+public:
+	explicit BatchGenerator(size_t threads);
+	~BatchGenerator() = default;
+	BatchGenerator(const BatchGenerator&) = delete;
+	BatchGenerator& operator=(const BatchGenerator&) = delete;
+
+	// write all the scenarios and return the number of bytes written of each scenario
+	// (0 for a scenario that its file can't be opened or written or that its objects are not valid states (see StateIndexer::IsValid),
+	// the error is reported and the other scenarios are written)
+	std::vector<size_t> Generate(const std::vector<BatchScenario>& scenarios);
+
+	size_t GetNumThreads() const { return m_pool.GetNumThreads(); }
+
+private:
+	GridTables m_tables;
+	ThreadPool m_pool;
+
+	size_t GenerateSingle(const BatchScenario& scenario);
+	// write the index of the blocks of a compressed scenario. returns false if the index could not be written
+	static bool WriteIndex(const GzipSink& gzipSink, const std::string& indexName);
+};
@@ -0,0 +1,240 @@
+#include "BeliefFilter.h"
+
+#include <algorithm>
+
+#include "POMDP_Writer.h"
+#include "BinaryModelFormat.h"
+#include "BinaryModelReader.h"
+
+BeliefFilter::BeliefFilter(const Dynamics& dynamics, const std::vector<Entry>& start)
+: m_dynamics(dynamics)
+, m_numObjects(dynamics.m_indexer.GetNumObjects())
+, m_numCells(dynamics.m_topology->GetNumCells())
+, m_epsilon(0.0)
+, m_belief()
+, m_pMap()
+, m_state(m_numObjects)
+, m_moveState(m_numObjects)
+, m_observation(m_numObjects)
+{
+	SetBelief(start);
+}
+
+void BeliefFilter::SetBelief(const std::vector<Entry>& belief)
+{
+	m_belief = belief;
+	std::sort(m_belief.begin(), m_belief.end(), [](const Entry& a, const Entry& b) { return a.m_idx < b.m_idx; });
+	double sum = 0.0;
+	for (const auto& entry : m_belief)
+	{
+		sum += entry.m_p;
+	}
+	Normalize(sum);
+}
+
+void BeliefFilter::SetEpsilon(double epsilon)
+{
+	m_epsilon = epsilon;
+}
+
+double BeliefFilter::Update(size_t action, size_t observation)
+{
+	m_dynamics.m_indexer.Unrank(observation, &m_observation[0]);
+	return Update(action, &m_observation[0]);
+}
+
+double BeliefFilter::Update(size_t action, const int *observation)
+{
+	const Action& act = m_dynamics.m_actions[action];
+	double selfPHit = m_dynamics.m_selfPHit;
+	bool isObservedDead = DEAD_ENEMY == observation[ENEMY_IDX];
+	m_pMap.Clear();
+	for (const auto& entry : m_belief)
+	{
+		m_dynamics.m_indexer.Unrank(entry.m_idx, &m_state[0]);
+		int self = m_state[0];
+		bool isAlive = DEAD_ENEMY != m_state[ENEMY_IDX];
+		// a dead enemy is observed exactly so a state with a dead enemy ends with a dead enemy
+		if (!isAlive && !isObservedDead)
+		{
+			continue;
+		}
+
+		// the enemy shoots before the action (the rest of the probability is of the states without loss)
+		double pEnemyHit = isAlive && m_dynamics.m_enemyFire->CanHit(m_state[ENEMY_IDX], self) ? m_dynamics.m_enemyPHit : 0.0;
+		size_t shot = act.m_isShoot && isAlive ? ShotObject(self, act.m_direction) : 0;
+		if (ENEMY_IDX == shot)
+		{
+			// the enemy is dead with pHit of the robot (the robot doesn't move)
+			if (isObservedDead)
+			{
+				m_state[ENEMY_IDX] = DEAD_ENEMY;
+				AddMoves(self, self, entry.m_p * (1 - pEnemyHit) * selfPHit, observation);
+			}
+			else
+			{
+				AddMoves(self, self, entry.m_p * (1 - pEnemyHit) * (1 - selfPHit), observation);
+			}
+		}
+		else if (isObservedDead && isAlive)
+		{
+			continue;
+		}
+		else if (shot > 0)
+		{
+			// a shot at a non-involved is a loss with pHit of the robot
+			AddMoves(self, self, entry.m_p * (1 - (pEnemyHit + selfPHit - pEnemyHit * selfPHit)), observation);
+		}
+		else
+		{
+			// a move out of the grid (and a shot that doesn't hit) is a stay
+			bool isMove = !act.m_isShoot && m_dynamics.m_topology->IsValidMove(self, act.m_direction);
+			int newSelf = isMove ? m_dynamics.m_topology->GetNeighbor(self, act.m_direction) : self;
+			AddMoves(self, newSelf, entry.m_p * (1 - pEnemyHit), observation);
+		}
+	}
+
+	// the probability of the observation is the sum of the end-states (the belief before the update is normalized)
+	double sum = 0.0;
+	for (const auto& entry : m_pMap)
+	{
+		sum += entry.m_p;
+	}
+	if (0 == sum)
+	{
+		return 0.0;
+	}
+
+	m_pMap.Sort();
+	m_belief.assign(m_pMap.begin(), m_pMap.end());
+	Normalize(sum);
+	return sum;
+}
+
+size_t BeliefFilter::ShotObject(int self, GridDirection direction) const
+{
+	// the first object in the track of the shot (a non-involved before the enemy in the same location)
+	const int *end = m_dynamics.m_selfFire->RayEnd(self, direction);
+	for (const int *shot = m_dynamics.m_selfFire->RayBegin(self, direction); shot != end; ++shot)
+	{
+		for (size_t i = ENEMY_IDX + 1; i < m_numObjects; ++i)
+		{
+			if (m_state[i] == *shot)
+			{
+				return i;
+			}
+		}
+		if (m_state[ENEMY_IDX] == *shot)
+		{
+			return ENEMY_IDX;
+		}
+	}
+
+	return 0;
+}
+
+void BeliefFilter::AddMoves(int self, int newSelf, double p, const int *observation)
+{
+	// the robot in the target is a win (no observation). the robot ends in newSelf or returns to self when it is corrected
+	if (static_cast<size_t>(newSelf) == m_dynamics.m_idxTarget || 0 == p || (observation[0] != newSelf && observation[0] != self))
+	{
+		return;
+	}
+
+	// the moves of the objects: move i is the direction of each object (digit of base NUM_DIRECTIONS)
+	// an object that can't move in a direction stays and a dead enemy has only the stay move
+	size_t numMoved = m_numObjects - 1;
+	size_t numMoves = 1;
+	for (size_t i = 0; i < numMoved; ++i)
+	{
+		numMoves *= NUM_DIRECTIONS;
+	}
+
+	const int *origins = &m_state[1];
+	for (size_t move = 0; move < numMoves; ++move)
+	{
+		double pMove = p;
+		size_t directions = move;
+		m_moveState[0] = newSelf;
+		for (size_t i = 0; i < numMoved && pMove > 0; ++i)
+		{
+			size_t direction = directions % NUM_DIRECTIONS;
+			directions /= NUM_DIRECTIONS;
+			if (DEAD_ENEMY == origins[i])
+			{
+				m_moveState[i + 1] = DEAD_ENEMY;
+				pMove *= DIR_STAY == direction;
+				continue;
+			}
+
+			int cell = m_dynamics.m_topology->GetNeighbor(origins[i], static_cast<GridDirection>(direction));
+			m_moveState[i + 1] = GridTopology::s_invalidCell == cell ? origins[i] : cell;
+			pMove *= DIR_STAY == direction ? m_dynamics.m_pStay[i] : m_dynamics.m_pMove[i];
+		}
+		if (0 == pMove)
+		{
+			continue;
+		}
+
+		POMDP_Writer::NoRepetitionCheckAndCorrect(&m_moveState[0], m_numObjects, origins, self);
+		if (m_moveState[0] != observation[0])
+		{
+			continue;
+		}
+		double pObs = ObservationProbability(&m_moveState[0], observation);
+		if (pObs > 0)
+		{
+			m_pMap.Add(m_dynamics.m_indexer.Rank(&m_moveState[0]), pMove * pObs);
+		}
+	}
+}
+
+double BeliefFilter::ObservationProbability(const int *state, const int *observation) const
+{
+	// the factors of the objects as in the observations of the writer (see POMDP_Writer::CalcObsFactors)
+	BinaryObservationFactor factors[StateIndexer::s_maxObjects];
+	const char *inRange = &m_dynamics.m_inObsRange[state[0] * (m_numCells + 1)];
+	for (size_t i = 1; i < m_numObjects; ++i)
+	{
+		bool isInRange = 0 != inRange[DEAD_ENEMY == state[i] ? m_numCells : state[i]];
+		factors[i - 1].m_location = state[i];
+		if (DEAD_ENEMY == state[i])
+		{
+			factors[i - 1].m_kind = OBS_DEAD;
+			factors[i - 1].m_p = isInRange ? 1 - m_dynamics.m_pObs : 1.0;
+		}
+		else
+		{
+			factors[i - 1].m_kind = isInRange ? OBS_EXACT : OBS_UNIFORM;
+			factors[i - 1].m_p = isInRange ? m_dynamics.m_pObs : 0.0;
+		}
+	}
+
+	return BinaryModelReader::ObservationProbability(factors, state[0], observation, m_numObjects, m_numCells);
+}
+
+void BeliefFilter::Normalize(double sum)
+{
+	for (auto & entry : m_belief)
+	{
+		entry.m_p /= sum;
+	}
+	// nothing is dropped when all the states are below epsilon
+	bool isAboveEpsilon = std::any_of(m_belief.begin(), m_belief.end(), [this](const Entry& entry) { return entry.m_p >= m_epsilon; });
+	if (m_epsilon <= 0 || !isAboveEpsilon)
+	{
+		return;
+	}
+
+	// drop the states below epsilon and normalize the rest
+	m_belief.erase(std::remove_if(m_belief.begin(), m_belief.end(), [this](const Entry& entry) { return entry.m_p < m_epsilon; }), m_belief.end());
+	sum = 0.0;
+	for (const auto& entry : m_belief)
+	{
+		sum += entry.m_p;
+	}
+	for (auto & entry : m_belief)
+	{
+		entry.m_p /= sum;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+#include "StateIndexer.h"
+#include "GridTopology.h"
+#include "LineOfFire.h"
+#include "ProbabilityAccumulator.h"
+
+//	bayes filter of the belief over the states of the writer for online tracking (created by POMDP_Writer::CreateBeliefFilter).
+//	the transitions are never calculated as a matrix: each state of the belief is moved by the moves of each object
+//	(the objects move independently and then the repetitions are corrected as in the writer) and the probability of the
+//	observation in each end-state is the product of the factors of the objects (see BinaryObservationFactor).
+//	the robot location and the dead enemy are observed exactly so the states that can't end in the observed robot location
+//	(or in the observed enemy) are dropped before the moves of their objects are calculated
+class BeliefFilter
+{
+public:
+	// belief of a single state (the idx of the state in StateIndexer)
+	using Entry = ProbabilityAccumulator::Entry;
+
+	// an action moves the robot in a direction (DIR_STAY for no move) or shoots in a direction
+	struct Action
+	{
+		GridDirection m_direction;
+		bool m_isShoot;
+	};
+
+	// the dynamics of the writer
+	struct Dynamics
+	{
+		explicit Dynamics(const StateIndexer& indexer) : m_indexer(indexer) {}
+
+		StateIndexer m_indexer;
+		std::shared_ptr<const GridTopology> m_topology;
+		std::shared_ptr<const LineOfFire> m_selfFire;
+		std::shared_ptr<const LineOfFire> m_enemyFire;
+		// the actions in the order of the actions of the model
+		std::vector<Action> m_actions;
+		size_t m_idxTarget = 0;
+		double m_selfPHit = 0.0;
+		double m_enemyPHit = 0.0;
+		double m_pObs = 0.0;
+		// probability of each object to stay and to move in each direction (the enemy and then the non-involved)
+		std::vector<double> m_pStay;
+		std::vector<double> m_pMove;
+		// the robot in cell observes an object in location: [cell * (numCells + 1) + location] (the last location is a dead enemy)
+		std::vector<char> m_inObsRange;
+	};
+
+	BeliefFilter(const Dynamics& dynamics, const std::vector<Entry>& start);
+
+	// the belief is normalized and sorted by state
+	void SetBelief(const std::vector<Entry>& belief);
+	const std::vector<Entry>& GetBelief() const { return m_belief; }
+	// states below epsilon are dropped after each update and the rest are normalized (default 0: nothing is dropped)
+	void SetEpsilon(double epsilon);
+
+	// update after action and observation: the locations of the robot and the objects (DEAD_ENEMY for a dead enemy).
+	// returns the probability of the observation (an observation with probability 0 doesn't change the belief)
+	double Update(size_t action, const int *observation);
+	// observation is the idx of the observation in StateIndexer
+	double Update(size_t action, size_t observation);
+
+private:
+	Dynamics m_dynamics;
+	size_t m_numObjects;
+	size_t m_numCells;
+	double m_epsilon;
+	std::vector<Entry> m_belief;
+	// probabilities of the end-states of an update
+	ProbabilityAccumulator m_pMap;
+	// locations of the state and of a move of the state
+	std::vector<int> m_state;
+	std::vector<int> m_moveState;
+	std::vector<int> m_observation;
+
+	// the first object in the shot of the robot (0 if the shot doesn't hit an object)
+	size_t ShotObject(int self, GridDirection direction) const;
+	// add the moves of the objects of m_state with the robot in newSelf (the robot was in self) to m_pMap
+	void AddMoves(int self, int newSelf, double p, const int *observation);
+	// probability of observation in the locations of a state
+	double ObservationProbability(const int *state, const int *observation) const;
+	void Normalize(double sum);
+};
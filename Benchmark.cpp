@@ -0,0 +1,307 @@
+//	benchmark of the pomdp writer: writes a sweep of scenarios (grid sizes, non-involved objects and shelters)
+//	to a sink that only counts the bytes and reports the time of each section, states/sec, bytes/sec and peak rss (of each scenario) as json.
+//	with a baseline (a json written by the benchmark) the results are compared to the baseline:
+//	a scenario that is slower than the baseline by more than the tolerance or writes a different number of bytes is a regression.
+//	the estimate of each scenario (POMDP_Writer::EstimateModel) is written next to the measures to check its calibration.
+//
+//	usage: pomdp_bench [--out <json>] [--baseline <json>] [--tolerance <fraction>] [--max-states <n>] [--threads <n>] [--repeat <n>]
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "POMDP_Writer.h"
+#include "StateIndexer.h"
+
+// time in seconds that a scenario can be slower than the baseline in addition to the tolerance
+static const double s_minSlack = 0.005;
+
+// time in seconds of the runs of a single scenario after which it is not repeated
+static const double s_repeatSeconds = 2.0;
+
+// sink that only counts the bytes (the benchmark measures the calculation and the formatting, not the disk)
+class CountingSink : public OutputSink
+{
+protected:
+	bool WriteIMP(const char *, size_t) override { return true; }
+};
+
+struct BenchScenario
+{
+	size_t m_gridSize;
+	size_t m_numNonInvolved;
+	size_t m_numShelters;
+};
+
+struct BenchResult
+{
+	std::string m_name;
+	BenchScenario m_scenario;
+	size_t m_numStates;
+	size_t m_bytes;
+	double m_seconds;
+	GenerationStats m_stats;
+	ModelEstimate m_estimate;
+	// peak rss of the scenario, or the growth of the peak of the process when the peak can't be reset (see ResetPeakRss)
+	size_t m_peakRssKb;
+	bool m_isPeakReset;
+};
+
+// reset the peak rss of the process to the current rss (only on linux). returns false if the peak was not reset
+static bool ResetPeakRss()
+{
+#if defined(__linux__)
+	std::ofstream clearRefs("/proc/self/clear_refs");
+	clearRefs << "5";
+	clearRefs.flush();
+	return clearRefs.good();
+#else
+	return false;
+#endif
+}
+
+static size_t PeakRssKb()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	return GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ? counters.PeakWorkingSetSize / 1024 : 0;
+#else
+#if defined(__linux__)
+	// the peak since the last reset (ru_maxrss is not reset)
+	std::ifstream status("/proc/self/status");
+	std::string line;
+	while (std::getline(status, line))
+	{
+		if (0 == line.compare(0, 6, "VmHWM:"))
+		{
+			return std::stoul(line.substr(6));
+		}
+	}
+#endif
+	struct rusage usage;
+	return getrusage(RUSAGE_SELF, &usage) == 0 ? static_cast<size_t>(usage.ru_maxrss) : 0;
+#endif
+}
+
+static std::string ScenarioName(const BenchScenario& scenario)
+{
+	return "g" + std::to_string(scenario.m_gridSize) + "_n" + std::to_string(scenario.m_numNonInvolved) + "_s" + std::to_string(scenario.m_numShelters);
+}
+
+// the objects are spread on the grid: robot in the bottom left corner, enemy in the top right corner,
+// non-involved objects and shelters on the cells between them. the target is the bottom right corner
+static BenchResult RunScenario(const BenchScenario& scenario, size_t threads, size_t repeat)
+{
+	size_t g = scenario.m_gridSize;
+	Point locSelf(0, g - 1, 0.5);
+	Move_Properties mSelf(0.2);
+	Self_Obj self(locSelf, mSelf, 2, 0.8, 2, 0.9);
+	Point locEnemy(g - 1, 0, 0.5);
+	Move_Properties mEnemy(0.6);
+	Attack_Obj enemy(locEnemy, mEnemy, 2, 0.3);
+
+	BenchResult result;
+	result.m_name = ScenarioName(scenario);
+	result.m_scenario = scenario;
+	result.m_numStates = StateIndexer(g, 2 + scenario.m_numNonInvolved).NumStates();
+	result.m_seconds = 0.0;
+
+	// the peak of the process is the peak of the previous scenarios unless it is reset
+	result.m_isPeakReset = ResetPeakRss();
+	size_t peakBefore = PeakRssKb();
+
+	// the fastest of the repeats is reported (the other runs are noise of the machine).
+	// a scenario is repeated only until its runs took s_repeatSeconds
+	double totalSeconds = 0.0;
+	for (size_t r = 0; r < repeat && totalSeconds < s_repeatSeconds; ++r)
+	{
+		POMDP_Writer writer(g, self, enemy);
+		for (size_t i = 0; i < scenario.m_numNonInvolved; ++i)
+		{
+			Point location((1 + i) % g, g - 1 - (1 + i) / g, 0.3);
+			Move_Properties movement(0.7);
+			Movable_Obj obj(location, movement);
+			writer.AddObj(obj);
+		}
+		for (size_t i = 0; i < scenario.m_numShelters; ++i)
+		{
+			Point location(g / 2, (1 + 2 * i) % g);
+			ObjInGrid obj(location);
+			writer.AddObj(obj);
+		}
+
+		if (0 == r)
+		{
+			result.m_estimate = writer.EstimateModel(g * g - 1, threads);
+		}
+		CountingSink sink;
+		GenerationStats stats = writer.SaveInFormat(sink, g * g - 1, threads);
+		result.m_bytes = stats.m_bytesWritten;
+		totalSeconds += stats.m_seconds;
+		if (0 == r || stats.m_seconds < result.m_seconds)
+		{
+			result.m_seconds = stats.m_seconds;
+			result.m_stats = stats;
+		}
+	}
+
+	size_t peak = PeakRssKb();
+	result.m_peakRssKb = result.m_isPeakReset ? peak : peak - std::min(peak, peakBefore);
+	return result;
+}
+
+static void WriteJson(std::ostream& out, const std::vector<BenchResult>& results, size_t threads)
+{
+	// a result in each line so the baseline can be read line by line (see ReadBaseline)
+	out << "{\n  \"benchmark\": \"pomdp_writer\",\n  \"threads\": " << threads << ",\n  \"results\": [\n";
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		const BenchResult& r = results[i];
+		const GenerationStats::SectionStats *sections = r.m_stats.m_sections;
+		double seconds = std::max(r.m_seconds, 1e-9);
+		out << "    {\"name\": \"" << r.m_name << "\", \"grid\": " << r.m_scenario.m_gridSize
+			<< ", \"nonInvolved\": " << r.m_scenario.m_numNonInvolved << ", \"shelters\": " << r.m_scenario.m_numShelters
+			<< ", \"states\": " << r.m_numStates << ", \"bytes\": " << r.m_bytes << ", \"seconds\": " << r.m_seconds
+			<< ", \"statesPerSec\": " << r.m_numStates / seconds << ", \"bytesPerSec\": " << r.m_bytes / seconds
+			<< ", \"sections\": {\"statesAndObs\": " << sections[GenerationStats::SECTION_NAMES].m_seconds
+			<< ", \"start\": " << sections[GenerationStats::SECTION_START].m_seconds
+			<< ", \"positions\": " << sections[GenerationStats::SECTION_POSITIONS].m_seconds
+			<< ", \"hits\": " << sections[GenerationStats::SECTION_HITS].m_seconds
+			<< ", \"observations\": " << sections[GenerationStats::SECTION_OBSERVATIONS].m_seconds << "}"
+			<< ", \"estimatedBytes\": " << r.m_estimate.m_bytes << ", \"estimatedSeconds\": " << r.m_estimate.m_seconds
+			<< (r.m_isPeakReset ? ", \"peakRssKb\": " : ", \"peakRssGrowthKb\": ") << r.m_peakRssKb << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+}
+
+// value of a number field in a result line of the json (0 if the field is missing)
+static double NumberField(const std::string& line, const std::string& field)
+{
+	size_t pos = line.find("\"" + field + "\": ");
+	return std::string::npos == pos ? 0.0 : atof(line.c_str() + pos + field.size() + 4);
+}
+
+// the bytes and the seconds of each scenario in the baseline. returns false if the file can't be read
+static bool ReadBaseline(const char *fileName, std::map<std::string, std::pair<double, double>>& baseline)
+{
+	std::ifstream in(fileName);
+	if (!in)
+	{
+		return false;
+	}
+
+	std::string line;
+	while (std::getline(in, line))
+	{
+		size_t pos = line.find("\"name\": \"");
+		if (std::string::npos != pos)
+		{
+			pos += 9;
+			std::string name = line.substr(pos, line.find('"', pos) - pos);
+			baseline[name] = std::make_pair(NumberField(line, "bytes"), NumberField(line, "seconds"));
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	const char *outFile = nullptr;
+	const char *baselineFile = nullptr;
+	double tolerance = 0.5;
+	size_t maxStates = 20000;
+	size_t threads = 1;
+	size_t repeat = 5;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		std::string arg = argv[i];
+		if ("--out" == arg) outFile = argv[i + 1];
+		else if ("--baseline" == arg) baselineFile = argv[i + 1];
+		else if ("--tolerance" == arg) tolerance = atof(argv[i + 1]);
+		else if ("--max-states" == arg) maxStates = std::stoul(argv[i + 1]);
+		else if ("--threads" == arg) threads = std::stoul(argv[i + 1]);
+		else if ("--repeat" == arg) repeat = std::max<size_t>(1, std::stoul(argv[i + 1]));
+		else
+		{
+			std::cerr << "unknown argument " << arg << "\n";
+			return 1;
+		}
+	}
+
+	// scenarios with more states than maxStates are skipped (the number of states grows as cells ^ objects)
+	std::vector<BenchResult> results;
+	for (size_t g = 3; g <= 10; ++g)
+	{
+		for (size_t n = 0; n <= 3; ++n)
+		{
+			for (size_t s = 0; s <= 2; ++s)
+			{
+				BenchScenario scenario = { g, n, s };
+				if (StateIndexer(g, 2 + n).NumStates() > maxStates)
+				{
+					continue;
+				}
+				results.push_back(RunScenario(scenario, threads, repeat));
+				std::cerr << results.back().m_name << ": " << results.back().m_seconds << " s\n";
+			}
+		}
+	}
+
+	if (nullptr != outFile)
+	{
+		std::ofstream out(outFile);
+		WriteJson(out, results, threads);
+	}
+	else
+	{
+		WriteJson(std::cout, results, threads);
+	}
+
+	if (nullptr == baselineFile)
+	{
+		return 0;
+	}
+
+	std::map<std::string, std::pair<double, double>> baseline;
+	if (!ReadBaseline(baselineFile, baseline))
+	{
+		std::cerr << "ERROR OPEN " << baselineFile << "\n";
+		return 1;
+	}
+
+	// the bytes must be the same as in the baseline (the text was changed otherwise) and the time in the tolerance
+	// (and in s_minSlack seconds, so the noise of the fast scenarios is not a regression)
+	int regressions = 0;
+	for (const auto& r : results)
+	{
+		auto itr = baseline.find(r.m_name);
+		if (itr == baseline.end())
+		{
+			continue;
+		}
+		if (static_cast<double>(r.m_bytes) != itr->second.first)
+		{
+			std::cerr << "REGRESSION " << r.m_name << ": " << r.m_bytes << " bytes instead of " << itr->second.first << "\n";
+			++regressions;
+		}
+		if (r.m_seconds > itr->second.second * (1 + tolerance) + s_minSlack)
+		{
+			std::cerr << "REGRESSION " << r.m_name << ": " << r.m_seconds << " s instead of " << itr->second.second << " s\n";
+			++regressions;
+		}
+	}
+
+	return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+//	layout of the binary model file (numbers are in the byte order of the writing machine, little endian on x86 / arm):
+//	header, section table (numSections entries) and the sections.
+//	every section starts on a multiple of s_binaryAlignment bytes from the start of the file
+//	so the arrays can be used directly from a memory mapping of the file (see BinaryModelReader).
+//
+//	sections:
+//	transitions of each action (numStates x numStates) are csr matrices of 3 sections each:
+//	row offsets (uint64 [rows + 1]), columns (uint32 [non-zeros]) and values (double [non-zeros]).
+//	observations are factors (BinaryObservationFactor [numStates * (numObjects - 1)]), a factor for each object
+//	except the robot in each end-state (the observation idx is the idx of the state observed, see StateIndexer).
+//	rewards (reward for acting in each state) and start (initial probability of each state) are double [numStates].
+//	state ids (uint64 [numStates], optional) are the idx of each state in StateIndexer when the model has only part of the states
+//	(ascending, win and loss are the last 2). without state ids the states are all the states of StateIndexer.
+//	the version is raised on every change of the layout.
+
+static const char s_binaryMagic[8] = { 'P', 'O', 'M', 'D', 'P', 'B', 'I', 'N' };
+static const uint32_t s_binaryVersion = 3;
+static const size_t s_binaryAlignment = 64;
+
+enum BinarySectionKind : uint32_t
+{
+	SECTION_T_ROW_OFFSETS = 0,
+	SECTION_T_COLUMNS = 1,
+	SECTION_T_VALUES = 2,
+	SECTION_O_FACTORS = 3,
+	SECTION_REWARDS = 4,
+	SECTION_START = 5,
+	SECTION_STATE_IDS = 6,
+};
+
+//	the observation of an end-state is drawn object after object (by the order of the objects in the state).
+//	the robot is always observed in its location. an object can't be observed in a location that was
+//	drawn to a previous object (free locations are the locations that were not drawn yet)
+enum BinaryObservationKind : uint32_t
+{
+	// the end-state has no observations (win and loss)
+	OBS_NONE = 0,
+	// the object is observed in a free location uniformly
+	OBS_UNIFORM = 1,
+	// the object is observed in its location with m_p and uniformly in the other free locations
+	// (uniformly in all free locations when its location is not free)
+	OBS_EXACT = 2,
+	// the dead enemy is observed dead with m_p
+	OBS_DEAD = 3,
+};
+
+struct BinaryModelHeader
+{
+	char m_magic[8];
+	uint32_t m_version;
+	uint32_t m_numActions;
+	uint64_t m_numStates;
+	uint64_t m_numObservations;
+	double m_discount;
+	uint64_t m_numSections;
+	uint32_t m_gridSize;
+	// number of objects in a state (robot, enemy and non-involved)
+	uint32_t m_numObjects;
+};
+
+struct BinarySection
+{
+	uint32_t m_kind;
+	// action of transitions sections (0 in other sections)
+	uint32_t m_action;
+	// from the start of the file
+	uint64_t m_offset;
+	uint64_t m_size;
+};
+
+struct BinaryObservationFactor
+{
+	// location of the object in the end-state (DEAD_ENEMY for dead enemy)
+	int32_t m_location;
+	uint32_t m_kind;
+	double m_p;
+};
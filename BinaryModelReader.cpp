@@ -0,0 +1,333 @@
+#include "BinaryModelReader.h"
+
+#include <memory.h>
+#include <limits>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+BinaryModelReader::BinaryModelReader()
+: m_data(nullptr)
+, m_size(0)
+#ifdef _WIN32
+, m_file(INVALID_HANDLE_VALUE)
+, m_mapping(nullptr)
+#endif
+, m_header(nullptr)
+, m_indexer()
+, m_transitions()
+, m_observationFactors(nullptr)
+, m_rewards(nullptr)
+, m_start(nullptr)
+, m_stateIds(nullptr)
+{
+}
+
+BinaryModelReader::~BinaryModelReader()
+{
+	Close();
+}
+
+bool BinaryModelReader::Open(const char *fileName)
+{
+	Close();
+	if (!Map(fileName) || !ReadSections())
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void BinaryModelReader::Close()
+{
+	Unmap();
+	m_header = nullptr;
+	m_indexer.reset();
+	m_transitions.clear();
+	m_observationFactors = nullptr;
+	m_rewards = nullptr;
+	m_start = nullptr;
+	m_stateIds = nullptr;
+}
+
+#ifdef _WIN32
+
+bool BinaryModelReader::Map(const char *fileName)
+{
+	m_file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	LARGE_INTEGER size;
+	if (INVALID_HANDLE_VALUE == m_file || !GetFileSizeEx(m_file, &size) || 0 == size.QuadPart)
+	{
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (nullptr == m_mapping)
+	{
+		return false;
+	}
+
+	m_data = static_cast<const char *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	m_size = static_cast<size_t>(size.QuadPart);
+	return nullptr != m_data;
+}
+
+void BinaryModelReader::Unmap()
+{
+	if (nullptr != m_data)
+	{
+		UnmapViewOfFile(m_data);
+	}
+	if (nullptr != m_mapping)
+	{
+		CloseHandle(m_mapping);
+	}
+	if (INVALID_HANDLE_VALUE != m_file)
+	{
+		CloseHandle(m_file);
+	}
+	m_data = nullptr;
+	m_size = 0;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool BinaryModelReader::Map(const char *fileName)
+{
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(fd, &status) != 0 || 0 == status.st_size)
+	{
+		close(fd);
+		return false;
+	}
+
+	// the mapping stays valid after closing the descriptor
+	void *data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (MAP_FAILED == data)
+	{
+		return false;
+	}
+
+	m_data = static_cast<const char *>(data);
+	m_size = status.st_size;
+	return true;
+}
+
+void BinaryModelReader::Unmap()
+{
+	if (nullptr != m_data)
+	{
+		munmap(const_cast<char *>(m_data), m_size);
+	}
+	m_data = nullptr;
+	m_size = 0;
+}
+
+#endif
+
+bool BinaryModelReader::ReadSections()
+{
+	m_header = reinterpret_cast<const BinaryModelHeader *>(m_data);
+	if (m_size < sizeof(BinaryModelHeader) || memcmp(m_header->m_magic, s_binaryMagic, sizeof(s_binaryMagic)) != 0
+		|| m_header->m_version != s_binaryVersion
+		|| m_header->m_numSections > (m_size - sizeof(BinaryModelHeader)) / sizeof(BinarySection))
+	{
+		return false;
+	}
+
+	// the states must be the states of the grid and the objects (the cells are int) and each action has the 3 sections of its matrix
+	uint64_t numCells = static_cast<uint64_t>(m_header->m_gridSize) * m_header->m_gridSize;
+	if (numCells > static_cast<uint64_t>(std::numeric_limits<int>::max()) || !StateIndexer::IsValid(m_header->m_gridSize, m_header->m_numObjects)
+		|| m_header->m_numActions > m_header->m_numSections / 3
+		|| GetNumStates() > m_size / sizeof(double))
+	{
+		return false;
+	}
+	m_indexer.reset(new StateIndexer(m_header->m_gridSize, m_header->m_numObjects));
+	if (m_indexer->NumLive() + m_indexer->NumDead() != GetNumObservations())
+	{
+		return false;
+	}
+
+	// a model with part of the states has the idx of its states (ascending and ending with win and loss)
+	m_stateIds = static_cast<const uint64_t *>(FindSection(SECTION_STATE_IDS, 0, GetNumStates(), sizeof(uint64_t)));
+	if (nullptr == m_stateIds)
+	{
+		if (m_indexer->NumStates() != GetNumStates())
+		{
+			return false;
+		}
+	}
+	else
+	{
+		size_t numStates = GetNumStates();
+		if (numStates < 2 || m_stateIds[numStates - 2] != m_indexer->WinIdx() || m_stateIds[numStates - 1] != m_indexer->LossIdx())
+		{
+			return false;
+		}
+		for (size_t i = 1; i < numStates; ++i)
+		{
+			if (m_stateIds[i] <= m_stateIds[i - 1])
+			{
+				return false;
+			}
+		}
+	}
+
+	m_transitions.resize(m_header->m_numActions);
+	for (size_t a = 0; a < m_transitions.size(); ++a)
+	{
+		if (!ReadMatrix(SECTION_T_ROW_OFFSETS, a, GetNumStates(), GetNumStates(), m_transitions[a]))
+		{
+			return false;
+		}
+	}
+
+	// the number of states is at most the size of the file (each state has a reward) so the number of factors doesn't overflow
+	m_observationFactors = static_cast<const BinaryObservationFactor *>(FindSection(SECTION_O_FACTORS, 0, GetNumStates() * (GetNumObjects() - 1), sizeof(BinaryObservationFactor)));
+	m_rewards = static_cast<const double *>(FindSection(SECTION_REWARDS, 0, GetNumStates(), sizeof(double)));
+	m_start = static_cast<const double *>(FindSection(SECTION_START, 0, GetNumStates(), sizeof(double)));
+	return nullptr != m_observationFactors && nullptr != m_rewards && nullptr != m_start;
+}
+
+double BinaryModelReader::GetObservationProbability(size_t endState, size_t observation) const
+{
+	size_t id = GetStateId(endState);
+	if (id >= m_indexer->WinIdx())
+	{
+		return 0.0;
+	}
+
+	int locations[StateIndexer::s_maxObjects];
+	m_indexer->Unrank(observation, locations);
+	return ObservationProbability(GetObservationFactors(endState), m_indexer->GetSelf(id), locations, GetNumObjects(), GetGridSize() * GetGridSize());
+}
+
+double BinaryModelReader::ObservationProbability(const BinaryObservationFactor *factors, int self, const int *observation, size_t numObjects, size_t numCells)
+{
+	if (observation[0] != self)
+	{
+		return 0.0;
+	}
+
+	// draw the objects one after the other (the observation has no repetitions so a location is free if it is not in the previous locations)
+	double p = 1.0;
+	size_t numTaken = 1;
+	for (size_t i = 1; i < numObjects; ++i)
+	{
+		const BinaryObservationFactor& factor = factors[i - 1];
+		if (OBS_NONE == factor.m_kind)
+		{
+			return 0.0;
+		}
+		else if (OBS_DEAD == factor.m_kind || DEAD_ENEMY == observation[i])
+		{
+			if (OBS_DEAD != factor.m_kind || DEAD_ENEMY != observation[i])
+			{
+				return 0.0;
+			}
+			p *= factor.m_p;
+			continue;
+		}
+
+		bool isLocationFree = OBS_EXACT == factor.m_kind;
+		for (size_t j = 0; j < i && isLocationFree; ++j)
+		{
+			isLocationFree = observation[j] != factor.m_location;
+		}
+
+		size_t numFree = numCells - numTaken;
+		if (isLocationFree)
+		{
+			p *= observation[i] == factor.m_location ? factor.m_p : (1 - factor.m_p) / (numFree - 1);
+		}
+		else
+		{
+			p /= numFree;
+		}
+		++numTaken;
+	}
+
+	return p;
+}
+
+const void *BinaryModelReader::FindSection(BinarySectionKind kind, size_t action, size_t count, size_t elementSize) const
+{
+	// a section larger than the file is not valid (and its size would overflow)
+	if (count > m_size / elementSize)
+	{
+		return nullptr;
+	}
+
+	size_t size = count * elementSize;
+	const BinarySection *sections = reinterpret_cast<const BinarySection *>(m_data + sizeof(BinaryModelHeader));
+	for (size_t i = 0; i < m_header->m_numSections; ++i)
+	{
+		const BinarySection& section = sections[i];
+		if (section.m_kind == kind && section.m_action == action)
+		{
+			// the section must be aligned and inside the file
+			bool isValid = section.m_size == size && section.m_offset % s_binaryAlignment == 0
+				&& section.m_offset <= m_size && section.m_size <= m_size - section.m_offset;
+			return isValid ? m_data + section.m_offset : nullptr;
+		}
+	}
+
+	return nullptr;
+}
+
+bool BinaryModelReader::ReadMatrix(BinarySectionKind rowOffsetsKind, size_t action, size_t numRows, size_t numCols, CsrView& view) const
+{
+	view.m_numRows = numRows;
+	view.m_numCols = numCols;
+	view.m_rowOffsets = static_cast<const uint64_t *>(FindSection(rowOffsetsKind, action, numRows + 1, sizeof(uint64_t)));
+	if (nullptr == view.m_rowOffsets || view.m_rowOffsets[0] != 0)
+	{
+		return false;
+	}
+
+	// the offsets are checked once here so the users of the view never read outside the sections
+	for (size_t row = 0; row < numRows; ++row)
+	{
+		if (view.m_rowOffsets[row + 1] < view.m_rowOffsets[row])
+		{
+			return false;
+		}
+	}
+
+	// the sizes of the sections must be the last offset
+	size_t numNonZeros = view.m_rowOffsets[numRows];
+	view.m_columns = static_cast<const uint32_t *>(FindSection(static_cast<BinarySectionKind>(rowOffsetsKind + 1), action, numNonZeros, sizeof(uint32_t)));
+	view.m_values = static_cast<const double *>(FindSection(static_cast<BinarySectionKind>(rowOffsetsKind + 2), action, numNonZeros, sizeof(double)));
+	if (nullptr == view.m_columns || nullptr == view.m_values)
+	{
+		return false;
+	}
+
+	for (size_t k = 0; k < numNonZeros; ++k)
+	{
+		if (view.m_columns[k] >= numCols)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
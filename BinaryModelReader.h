@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "BinaryModelFormat.h"
+#include "StateIndexer.h"
+
+//	zero-copy reader of the binary model (see BinaryModelFormat.h).
+//	the file is memory mapped and the matrices point directly to the mapping (valid until Close)
+class BinaryModelReader
+{
+public:
+	// csr matrix inside the mapping
+	struct CsrView
+	{
+		size_t m_numRows;
+		size_t m_numCols;
+		const uint64_t *m_rowOffsets;
+		const uint32_t *m_columns;
+		const double *m_values;
+	};
+
+	BinaryModelReader();
+	~BinaryModelReader();
+	BinaryModelReader(const BinaryModelReader&) = delete;
+	BinaryModelReader& operator=(const BinaryModelReader&) = delete;
+
+	// map the file and check its layout. returns false if the file can't be mapped or it is not a valid model
+	bool Open(const char *fileName);
+	void Close();
+
+	size_t GetNumActions() const { return m_header->m_numActions; }
+	size_t GetNumStates() const { return m_header->m_numStates; }
+	size_t GetNumObservations() const { return m_header->m_numObservations; }
+	double GetDiscount() const { return m_header->m_discount; }
+	size_t GetGridSize() const { return m_header->m_gridSize; }
+	size_t GetNumObjects() const { return m_header->m_numObjects; }
+	// idx of the states and the observations of the model
+	const StateIndexer& GetIndexer() const { return *m_indexer; }
+
+	const CsrView& GetTransitions(size_t action) const { return m_transitions[action]; }
+	// observation factors of endState (numObjects - 1 factors)
+	const BinaryObservationFactor *GetObservationFactors(size_t endState) const { return m_observationFactors + endState * (GetNumObjects() - 1); }
+	double GetObservationProbability(size_t endState, size_t observation) const;
+	// double [numStates]
+	const double *GetRewards() const { return m_rewards; }
+	const double *GetStart() const { return m_start; }
+	// idx of the state in the indexer (the states of the model may be only the reachable states)
+	size_t GetStateId(size_t state) const { return nullptr == m_stateIds ? state : m_stateIds[state]; }
+
+	// probability of observation (locations of the objects) given the factors of the end-state and the location of the robot
+	static double ObservationProbability(const BinaryObservationFactor *factors, int self, const int *observation, size_t numObjects, size_t numCells);
+
+private:
+	const char *m_data;
+	size_t m_size;
+#ifdef _WIN32
+	void *m_file;
+	void *m_mapping;
+#endif
+
+	const BinaryModelHeader *m_header;
+	std::unique_ptr<StateIndexer> m_indexer;
+	std::vector<CsrView> m_transitions;
+	const BinaryObservationFactor *m_observationFactors;
+	const double *m_rewards;
+	const double *m_start;
+	// nullptr when the model has all the states
+	const uint64_t *m_stateIds;
+
+	bool Map(const char *fileName);
+	void Unmap();
+	// check the sections and set the views. returns false if the layout is not valid
+	bool ReadSections();
+	// returns the data of the section or nullptr if the section is missing or its size is not count elements of elementSize
+	const void *FindSection(BinarySectionKind kind, size_t action, size_t count, size_t elementSize) const;
+	// set the view of a matrix. returns false if the offsets are not ascending from 0 to the sizes of the sections or a column is not below numCols
+	bool ReadMatrix(BinarySectionKind rowOffsetsKind, size_t action, size_t numRows, size_t numCols, CsrView& view) const;
+};
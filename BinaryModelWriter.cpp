@@ -0,0 +1,58 @@
+#include "BinaryModelWriter.h"
+
+#include <memory.h>
+
+BinaryModelWriter::BinaryModelWriter(size_t gridSize, size_t numObjects, size_t numActions, size_t numStates, size_t numObservations, double discount)
+: m_header()
+, m_sections()
+, m_data()
+{
+	memcpy(m_header.m_magic, s_binaryMagic, sizeof(s_binaryMagic));
+	m_header.m_version = s_binaryVersion;
+	m_header.m_numActions = static_cast<uint32_t>(numActions);
+	m_header.m_numStates = numStates;
+	m_header.m_numObservations = numObservations;
+	m_header.m_discount = discount;
+	m_header.m_numSections = 0;
+	m_header.m_gridSize = static_cast<uint32_t>(gridSize);
+	m_header.m_numObjects = static_cast<uint32_t>(numObjects);
+}
+
+void BinaryModelWriter::AddSection(BinarySectionKind kind, size_t action, const void *data, size_t size)
+{
+	m_sections.push_back(BinarySection{ kind, static_cast<uint32_t>(action), 0, size });
+	m_data.push_back(data);
+}
+
+void BinaryModelWriter::AddMatrix(BinarySectionKind rowOffsetsKind, size_t action, const CsrMatrix& matrix)
+{
+	AddSection(rowOffsetsKind, action, matrix.m_rowOffsets.data(), matrix.m_rowOffsets.size() * sizeof(uint64_t));
+	AddSection(static_cast<BinarySectionKind>(rowOffsetsKind + 1), action, matrix.m_columns.data(), matrix.m_columns.size() * sizeof(uint32_t));
+	AddSection(static_cast<BinarySectionKind>(rowOffsetsKind + 2), action, matrix.m_values.data(), matrix.m_values.size() * sizeof(double));
+}
+
+size_t BinaryModelWriter::Write(OutputSink& sink)
+{
+	// place the sections after the header and the table
+	m_header.m_numSections = m_sections.size();
+	size_t offset = sizeof(BinaryModelHeader) + m_sections.size() * sizeof(BinarySection);
+	for (auto & section : m_sections)
+	{
+		offset = Align(offset);
+		section.m_offset = offset;
+		offset += section.m_size;
+	}
+
+	static const char s_padding[s_binaryAlignment] = {};
+	bool isWritten = sink.Write(reinterpret_cast<const char *>(&m_header), sizeof(m_header));
+	isWritten &= sink.Write(reinterpret_cast<const char *>(m_sections.data()), m_sections.size() * sizeof(BinarySection));
+	offset = sizeof(BinaryModelHeader) + m_sections.size() * sizeof(BinarySection);
+	for (size_t i = 0; i < m_sections.size() && isWritten; ++i)
+	{
+		isWritten &= sink.Write(s_padding, m_sections[i].m_offset - offset);
+		isWritten &= sink.Write(static_cast<const char *>(m_data[i]), m_sections[i].m_size);
+		offset = m_sections[i].m_offset + m_sections[i].m_size;
+	}
+
+	return isWritten ? offset : 0;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include "BinaryModelFormat.h"
+#include "SparseModelBuilder.h"
+#include "OutputSink.h"
+
+//	writes sections of the model in the binary model layout (see BinaryModelFormat.h).
+//	the sections are not copied so their data must stay valid until Write
+class BinaryModelWriter
+{
+public:
+	BinaryModelWriter(size_t gridSize, size_t numObjects, size_t numActions, size_t numStates, size_t numObservations, double discount);
+
+	void AddSection(BinarySectionKind kind, size_t action, const void *data, size_t size);
+	// add the 3 sections of a csr matrix (rowOffsetsKind is the kind of the row offsets section)
+	void AddMatrix(BinarySectionKind rowOffsetsKind, size_t action, const CsrMatrix& matrix);
+
+	// write the header, the section table and the sections. returns the number of bytes written (0 if the write failed)
+	size_t Write(OutputSink& sink);
+
+private:
+	BinaryModelHeader m_header;
+	std::vector<BinarySection> m_sections;
+	std::vector<const void *> m_data;
+
+	static size_t Align(size_t offset) { return (offset + s_binaryAlignment - 1) / s_binaryAlignment * s_binaryAlignment; }
+};
@@ -0,0 +1,97 @@
+#include "ChunkBuffer.h"
+#include "TextFormat.h"
+
+#include <cstring>
+
+ChunkBuffer::ChunkBuffer(OutputSink& sink, size_t chunkSize)
+: m_sink(sink)
+, m_chunk(chunkSize)
+, m_used(0)
+, m_flushed(0)
+, m_isFailed(false)
+{
+}
+
+ChunkBuffer::~ChunkBuffer()
+{
+	Flush();
+}
+
+void ChunkBuffer::Append(const char * data, size_t size)
+{
+	// fill the chunk and flush it until the rest of the data fits in the chunk
+	while (m_used + size > m_chunk.size())
+	{
+		size_t toCopy = m_chunk.size() - m_used;
+		memcpy(m_chunk.data() + m_used, data, toCopy);
+		m_used += toCopy;
+		data += toCopy;
+		size -= toCopy;
+		Flush();
+	}
+
+	memcpy(m_chunk.data() + m_used, data, size);
+	m_used += size;
+}
+
+ChunkBuffer& ChunkBuffer::operator+=(const char * str)
+{
+	Append(str, strlen(str));
+	return *this;
+}
+
+ChunkBuffer& ChunkBuffer::operator+=(char c)
+{
+	if (m_used == m_chunk.size())
+	{
+		Flush();
+	}
+	m_chunk[m_used++] = c;
+	return *this;
+}
+
+void ChunkBuffer::AppendInteger(long long value)
+{
+	char *first = Reserve(TextFormat::s_maxNumber);
+	Commit(TextFormat::Integer(first, first + TextFormat::s_maxNumber, value));
+}
+
+void ChunkBuffer::AppendFixed(double value, int precision)
+{
+	char *first = Reserve(TextFormat::s_maxNumber);
+	Commit(TextFormat::Fixed(first, first + TextFormat::s_maxNumber, value, precision));
+}
+
+void ChunkBuffer::AppendGeneral(double value, int precision)
+{
+	char *first = Reserve(TextFormat::s_maxNumber);
+	Commit(TextFormat::General(first, first + TextFormat::s_maxNumber, value, precision));
+}
+
+char *ChunkBuffer::Reserve(size_t size)
+{
+	if (m_used + size > m_chunk.size())
+	{
+		Flush();
+		// a chunk smaller than a single text grows (only for very small chunks)
+		if (size > m_chunk.size())
+		{
+			m_chunk.resize(size);
+		}
+	}
+
+	return m_chunk.data() + m_used;
+}
+
+void ChunkBuffer::Flush()
+{
+	if (0 == m_used)
+	{
+		return;
+	}
+
+	// the caller reports the failure (the text is still counted so the sizes of the sections stay the same)
+	m_isFailed = m_isFailed || !m_sink.Write(m_chunk.data(), m_used);
+	m_flushed += m_used;
+	m_used = 0;
+}
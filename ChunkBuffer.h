@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "OutputSink.h"
+
+//	fixed size buffer for the pomdp text. the text is appended to the chunk
+//	and the chunk is written to the sink each time it is full,
+//	so the memory of the writer is constant no matter how big the model is.
+class ChunkBuffer
+{
+public:
+	static const size_t s_defaultChunkSize = 1 << 16;
+
+	explicit ChunkBuffer(OutputSink& sink, size_t chunkSize = s_defaultChunkSize);
+	~ChunkBuffer();
+	ChunkBuffer(const ChunkBuffer&) = delete;
+	ChunkBuffer& operator=(const ChunkBuffer&) = delete;
+
+	void Append(const char *data, size_t size);
+
+	ChunkBuffer& operator+=(const std::string& str) { Append(str.data(), str.size()); return *this; }
+	ChunkBuffer& operator+=(const char *str);
+	ChunkBuffer& operator+=(char c);
+
+	// append numbers without allocations (see TextFormat for the precision)
+	void AppendInteger(long long value);
+	void AppendFixed(double value, int precision);
+	void AppendGeneral(double value, int precision);
+
+	// pointer to at least size free bytes in the chunk (the chunk is flushed when needed).
+	// text written there is appended by Commit with the end of the text
+	char *Reserve(size_t size);
+	void Commit(const char *end) { m_used = end - m_chunk.data(); }
+
+	// write the chunk to the sink. after a failed write the text is dropped (see IsFailed)
+	void Flush();
+	// a write to the sink failed (the text after the failure was not written)
+	bool IsFailed() const { return m_isFailed; }
+
+	// bytes appended so far (including bytes still in the chunk)
+	size_t GetBytesWritten() const { return m_flushed + m_used; }
+	OutputSink& GetSink() { return m_sink; }
+
+private:
+	OutputSink& m_sink;
+	std::vector<char> m_chunk;
+	size_t m_used;
+	size_t m_flushed;
+	bool m_isFailed;
+};
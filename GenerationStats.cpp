@@ -0,0 +1,66 @@
+#include "GenerationStats.h"
+
+#include <cstdio>
+
+static const char *s_sectionNames[GenerationStats::NUM_SECTIONS] = { "names", "start", "positions", "hits", "observations" };
+
+GenerationStats::Counters& GenerationStats::Counters::operator+=(const Counters& other)
+{
+	m_states += other.m_states;
+	m_rows += other.m_rows;
+	m_lines += other.m_lines;
+	m_mapInsertions += other.m_mapInsertions;
+	return *this;
+}
+
+const char *GenerationStats::GetSectionName(Section section)
+{
+	return s_sectionNames[section];
+}
+
+GenerationStats::Counters GenerationStats::GetTotalCounters() const
+{
+	Counters total;
+	for (const auto& section : m_sections)
+	{
+		total += section.m_counters;
+	}
+
+	return total;
+}
+
+// the counters as fields of a json object
+static std::string CountersJson(const GenerationStats::Counters& counters)
+{
+	return "\"states\": " + std::to_string(counters.m_states) + ", \"rows\": " + std::to_string(counters.m_rows)
+		+ ", \"lines\": " + std::to_string(counters.m_lines) + ", \"mapInsertions\": " + std::to_string(counters.m_mapInsertions);
+}
+
+static std::string SecondsJson(double seconds)
+{
+	char text[32];
+	snprintf(text, sizeof(text), "%.9g", seconds);
+	return text;
+}
+
+std::string GenerationStats::ToJson() const
+{
+	std::string json = "{\"seconds\": " + SecondsJson(m_seconds) + ", \"bytesWritten\": " + std::to_string(m_bytesWritten)
+		+ ", \"peakBufferSize\": " + std::to_string(m_peakBufferSize) + ", \"threads\": " + std::to_string(m_threads)
+		+ ", " + CountersJson(GetTotalCounters()) + ", \"sections\": {";
+	for (size_t i = 0; i < NUM_SECTIONS; ++i)
+	{
+		const SectionStats& section = m_sections[i];
+		json += std::string(0 == i ? "" : ", ") + "\"" + s_sectionNames[i] + "\": {\"seconds\": " + SecondsJson(section.m_seconds)
+			+ ", \"bytes\": " + std::to_string(section.m_bytes) + ", " + CountersJson(section.m_counters)
+			+ ", \"cached\": " + (section.m_isCached ? "true" : "false") + "}";
+	}
+	json += "}";
+	if (IsFailed())
+	{
+		json += ", \"error\": \"" + m_error + "\"";
+	}
+	json += "}\n";
+
+	return json;
+}
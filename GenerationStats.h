@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//	statistics of a single save of the pomdp format (returned by POMDP_Writer::SaveInFormat).
+//	each calculation task counts in its own counters and the counters are summed when the task is merged,
+//	so counting needs no synchronization between the threads
+struct GenerationStats
+{
+	// parts of the text in the order they are written
+	enum Section
+	{
+		SECTION_NAMES = 0,
+		SECTION_START,
+		SECTION_POSITIONS,
+		SECTION_HITS,
+		SECTION_OBSERVATIONS,
+		NUM_SECTIONS
+	};
+
+	struct Counters
+	{
+		// states enumerated (a state is counted for each action it is calculated for)
+		uint64_t m_states = 0;
+		// rows of T: or O: (the lines of a state and an action)
+		uint64_t m_rows = 0;
+		// lines of T: and O: written
+		uint64_t m_lines = 0;
+		// new end-states inserted to the probability map of a row
+		uint64_t m_mapInsertions = 0;
+
+		Counters& operator+=(const Counters& other);
+	};
+
+	struct SectionStats
+	{
+		double m_seconds = 0.0;
+		uint64_t m_bytes = 0;
+		Counters m_counters;
+		// the section was copied from the section cache (it was not calculated)
+		bool m_isCached = false;
+	};
+
+	SectionStats m_sections[NUM_SECTIONS];
+	double m_seconds = 0.0;
+	uint64_t m_bytesWritten = 0;
+	// largest text of a single calculation task held in memory before it is written (0 without threads)
+	uint64_t m_peakBufferSize = 0;
+	size_t m_threads = 1;
+	// the error that stopped the save (empty when all the text was written)
+	std::string m_error;
+
+	bool IsFailed() const { return !m_error.empty(); }
+	static const char *GetSectionName(Section section);
+	// totals of all the sections
+	Counters GetTotalCounters() const;
+	// the statistics as a json object
+	std::string ToJson() const;
+};
@@ -0,0 +1,106 @@
+#include "GridSymmetry.h"
+
+const size_t GridSymmetry::s_numSymmetries;
+const size_t GridSymmetry::s_identity;
+
+// linear part of each symmetry: (x, y) -> (a * x + b * y, c * x + d * y) moved back into the grid
+struct SymmetryMatrix
+{
+	int a, b, c, d;
+};
+
+static const SymmetryMatrix s_matrices[GridSymmetry::s_numSymmetries] =
+{
+	{ 1, 0, 0, 1 },		// identity
+	{ 0, -1, 1, 0 },	// rotation by 90
+	{ -1, 0, 0, -1 },	// rotation by 180
+	{ 0, 1, -1, 0 },	// rotation by 270
+	{ -1, 0, 0, 1 },	// reflection of x
+	{ 1, 0, 0, -1 },	// reflection of y
+	{ 0, 1, 1, 0 },		// transpose
+	{ 0, -1, -1, 0 },	// anti-transpose
+};
+
+// move of each direction
+static const int s_dx[NUM_DIRECTIONS] = { 0, 1, -1, 0, 0 };
+static const int s_dy[NUM_DIRECTIONS] = { 0, 0, 0, 1, -1 };
+
+GridSymmetry::GridSymmetry(const GridTopology& topology)
+: m_numCells(topology.GetNumCells())
+, m_cells(s_numSymmetries * topology.GetNumCells())
+{
+	int last = static_cast<int>(topology.GetGridSize()) - 1;
+	for (size_t s = 0; s < s_numSymmetries; ++s)
+	{
+		const SymmetryMatrix& m = s_matrices[s];
+		// a negative coefficient moves the coordinate to the other side of the grid
+		int offsetX = (m.a + m.b < 0) * last;
+		int offsetY = (m.c + m.d < 0) * last;
+		for (int cell = 0; cell < static_cast<int>(m_numCells); ++cell)
+		{
+			int x = topology.GetX(cell);
+			int y = topology.GetY(cell);
+			m_cells[s * m_numCells + cell] = topology.GetCell(m.a * x + m.b * y + offsetX, m.c * x + m.d * y + offsetY);
+		}
+
+		for (int d = 0; d < NUM_DIRECTIONS; ++d)
+		{
+			int dx = m.a * s_dx[d] + m.b * s_dy[d];
+			int dy = m.c * s_dx[d] + m.d * s_dy[d];
+			for (int mapped = 0; mapped < NUM_DIRECTIONS; ++mapped)
+			{
+				if (s_dx[mapped] == dx && s_dy[mapped] == dy)
+				{
+					m_directions[s][d] = static_cast<GridDirection>(mapped);
+				}
+			}
+		}
+	}
+
+	// the inverse maps the cells of the symmetry back to their cells
+	for (size_t s = 0; s < s_numSymmetries; ++s)
+	{
+		for (size_t inverse = 0; inverse < s_numSymmetries; ++inverse)
+		{
+			bool isInverse = true;
+			for (int cell = 0; cell < static_cast<int>(m_numCells) && isInverse; ++cell)
+			{
+				isInverse = MapCell(inverse, MapCell(s, cell)) == cell;
+			}
+			if (isInverse)
+			{
+				m_inverse[s] = inverse;
+				break;
+			}
+		}
+	}
+}
+
+std::vector<size_t> GridSymmetry::Preserving(int target, const std::vector<int>& shelters) const
+{
+	std::vector<bool> isShelter(m_numCells, false);
+	for (int shelter : shelters)
+	{
+		if (shelter >= 0 && static_cast<size_t>(shelter) < m_numCells)
+		{
+			isShelter[shelter] = true;
+		}
+	}
+	bool isTargetInGrid = target >= 0 && static_cast<size_t>(target) < m_numCells;
+
+	std::vector<size_t> symmetries;
+	for (size_t s = 0; s < s_numSymmetries; ++s)
+	{
+		bool isPreserving = !isTargetInGrid || MapCell(s, target) == target;
+		for (int cell = 0; cell < static_cast<int>(m_numCells) && isPreserving; ++cell)
+		{
+			isPreserving = isShelter[cell] == isShelter[MapCell(s, cell)];
+		}
+		if (isPreserving)
+		{
+			symmetries.push_back(s);
+		}
+	}
+
+	return symmetries;
+}
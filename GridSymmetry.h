@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "GridTopology.h"
+
+//	the 8 symmetries of the square grid (rotations and reflections, D4).
+//	each symmetry maps the cells of the grid to cells and the directions of moves to directions
+//	so that the neighbor of a cell in a direction is mapped to the neighbor of the mapped cell in the mapped direction
+class GridSymmetry
+{
+public:
+	static const size_t s_numSymmetries = 8;
+	// symmetry that maps every cell to itself
+	static const size_t s_identity = 0;
+
+	explicit GridSymmetry(const GridTopology& topology);
+	~GridSymmetry() = default;
+
+	int MapCell(size_t symmetry, int cell) const { return m_cells[symmetry * m_numCells + cell]; }
+	GridDirection MapDirection(size_t symmetry, GridDirection direction) const { return m_directions[symmetry][direction]; }
+	size_t Inverse(size_t symmetry) const { return m_inverse[symmetry]; }
+
+	// symmetries that keep target in its cell (target outside the grid is kept by all) and map the shelters to shelters.
+	// the identity is always the first
+	std::vector<size_t> Preserving(int target, const std::vector<int>& shelters) const;
+
+private:
+	size_t m_numCells;
+	// cell of each symmetry and cell (m_numCells for each symmetry)
+	std::vector<int> m_cells;
+	GridDirection m_directions[s_numSymmetries][NUM_DIRECTIONS];
+	size_t m_inverse[s_numSymmetries];
+};
@@ -0,0 +1,36 @@
+#include "GridTables.h"
+
+#include <algorithm>
+
+std::shared_ptr<const GridTopology> GridTables::GetTopology(size_t gridSize)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return GetTopologyIMP(gridSize);
+}
+
+std::shared_ptr<const LineOfFire> GridTables::GetLineOfFire(size_t gridSize, const std::vector<int>& shelters, size_t range)
+{
+	// the shots don't depend on the order of the shelters
+	fireKey_t key(gridSize, shelters, range);
+	std::sort(std::get<1>(key).begin(), std::get<1>(key).end());
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto itr = m_linesOfFire.find(key);
+	if (itr == m_linesOfFire.end())
+	{
+		itr = m_linesOfFire.emplace(key, std::make_shared<LineOfFire>(*GetTopologyIMP(gridSize), shelters, range)).first;
+	}
+
+	return itr->second;
+}
+
+std::shared_ptr<const GridTopology> GridTables::GetTopologyIMP(size_t gridSize)
+{
+	auto itr = m_topologies.find(gridSize);
+	if (itr == m_topologies.end())
+	{
+		itr = m_topologies.emplace(gridSize, std::make_shared<GridTopology>(gridSize)).first;
+	}
+
+	return itr->second;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <mutex>
+
+#include "GridTopology.h"
+#include "LineOfFire.h"
+
+//	tables of the grid shared between writers (thread safe). the topology of a grid size and the shots of
+//	a grid size, shelters and range are calculated once and kept until the tables are destroyed
+class GridTables
+{
+public:
+	GridTables() = default;
+	~GridTables() = default;
+	GridTables(const GridTables&) = delete;
+	GridTables& operator=(const GridTables&) = delete;
+
+	std::shared_ptr<const GridTopology> GetTopology(size_t gridSize);
+	// shelters are the cells of the shelters (in any order)
+	std::shared_ptr<const LineOfFire> GetLineOfFire(size_t gridSize, const std::vector<int>& shelters, size_t range);
+
+private:
+	using fireKey_t = std::tuple<size_t, std::vector<int>, size_t>;
+
+	std::mutex m_mutex;
+	std::map<size_t, std::shared_ptr<const GridTopology>> m_topologies;
+	std::map<fireKey_t, std::shared_ptr<const LineOfFire>> m_linesOfFire;
+
+	// the topology of the grid size (the mutex is locked)
+	std::shared_ptr<const GridTopology> GetTopologyIMP(size_t gridSize);
+};
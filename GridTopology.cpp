@@ -0,0 +1,44 @@
+#include "GridTopology.h"
+
+const int GridTopology::s_invalidCell;
+
+GridTopology::GridTopology(size_t gridSize)
+: m_gridSize(gridSize)
+, m_neighbors(gridSize * gridSize)
+, m_validMoves(gridSize * gridSize, 0)
+, m_numEdges(gridSize * gridSize, 0)
+, m_x(gridSize * gridSize)
+, m_y(gridSize * gridSize)
+{
+	static const int s_dx[NUM_DIRECTIONS] = { 0, 1, -1, 0, 0 };
+	static const int s_dy[NUM_DIRECTIONS] = { 0, 0, 0, 1, -1 };
+	int size = static_cast<int>(gridSize);
+
+	for (int cell = 0; cell < size * size; ++cell)
+	{
+		int x = cell % size;
+		int y = cell / size;
+		m_x[cell] = x;
+		m_y[cell] = y;
+		m_numEdges[cell] = (x == 0) + (x == size - 1) + (y == 0) + (y == size - 1);
+
+		for (int d = 0; d < NUM_DIRECTIONS; ++d)
+		{
+			int newX = x + s_dx[d];
+			int newY = y + s_dy[d];
+			bool isValid = newX >= 0 && newX < size && newY >= 0 && newY < size;
+			m_neighbors[cell].m_cells[d] = isValid ? GetCell(newX, newY) : s_invalidCell;
+			m_validMoves[cell] |= isValid << d;
+		}
+	}
+}
+
+size_t GridTopology::Distance(int cell, int other) const
+{
+	int dx = m_x[cell] - m_x[other];
+	int dy = m_y[cell] - m_y[other];
+	dx = dx < 0 ? -dx : dx;
+	dy = dy < 0 ? -dy : dy;
+
+	return dx > dy ? dx : dy;
+}
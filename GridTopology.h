@@ -0,0 +1,62 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// directions of a move in the grid (the order of the moves of an object in the move states)
+enum GridDirection
+{
+	DIR_STAY = 0,
+	DIR_EAST,		// x + 1
+	DIR_WEST,		// x - 1
+	DIR_SOUTH,		// y + 1
+	DIR_NORTH,		// y - 1
+	NUM_DIRECTIONS
+};
+
+//	tables of the cells of a gridSize x gridSize grid (calculated once for the grid size):
+//	the neighbor of each cell in each direction, the valid directions of each cell, and the coordinates of each cell.
+//	cell idx is x + y * gridSize
+class GridTopology
+{
+public:
+	// neighbor of a cell in a direction that leaves the grid
+	static const int s_invalidCell = -1;
+
+	explicit GridTopology(size_t gridSize);
+	~GridTopology() = default;
+
+	size_t GetGridSize() const { return m_gridSize; }
+	size_t GetNumCells() const { return m_x.size(); }
+
+	int GetX(int cell) const { return m_x[cell]; }
+	int GetY(int cell) const { return m_y[cell]; }
+	int GetCell(int x, int y) const { return x + y * static_cast<int>(m_gridSize); }
+
+	// neighbor of cell in direction (s_invalidCell outside the grid). the neighbor in DIR_STAY is the cell itself
+	int GetNeighbor(int cell, GridDirection direction) const { return m_neighbors[cell].m_cells[direction]; }
+	// the NUM_DIRECTIONS neighbors of cell in the order of the directions
+	const int *GetNeighbors(int cell) const { return m_neighbors[cell].m_cells; }
+	// bit d is set if the move from cell in direction d stays in the grid
+	uint8_t GetValidMoves(int cell) const { return m_validMoves[cell]; }
+	bool IsValidMove(int cell, GridDirection direction) const { return (m_validMoves[cell] >> direction) & 1; }
+	// number of edges of the grid the cell touches
+	size_t CountEdges(int cell) const { return m_numEdges[cell]; }
+	// chebyshev distance between two cells
+	size_t Distance(int cell, int other) const;
+
+private:
+	// neighbors of a single cell (aligned so the neighbors of a cell are in a single cache line)
+	struct alignas(32) Neighbors
+	{
+		int m_cells[NUM_DIRECTIONS];
+	};
+
+	size_t m_gridSize;
+	std::vector<Neighbors> m_neighbors;
+	std::vector<uint8_t> m_validMoves;
+	std::vector<uint8_t> m_numEdges;
+	std::vector<int> m_x;
+	std::vector<int> m_y;
+};
@@ -0,0 +1,199 @@
+#include "GzipSink.h"
+
+#include <algorithm>
+#include <zlib.h>
+
+// window bits of deflate and inflate for a gzip header and trailer (instead of zlib)
+static const int s_gzipWindowBits = 15 + 16;
+static const int s_memLevel = 8;
+
+GzipSink::GzipSink(OutputSink& out, size_t threads, int level, size_t blockSize)
+: m_out(out)
+, m_level(level)
+, m_blockSize(blockSize > 0 ? blockSize : s_defaultBlockSize)
+, m_pool()
+, m_block()
+, m_pending()
+, m_index()
+, m_offset(0)
+, m_compressedOffset(0)
+{
+	if (threads > 1)
+	{
+		m_pool.reset(new ThreadPool(threads));
+	}
+	m_block.reserve(m_blockSize);
+}
+
+GzipSink::~GzipSink()
+{
+	// the blocks in compression refer to the pending blocks so they are finished before the members are destroyed
+	Flush();
+}
+
+bool GzipSink::WriteIMP(const char *data, size_t size)
+{
+	// the text is cut to blocks of exactly m_blockSize (except the blocks that end with a flush)
+	while (size > 0)
+	{
+		size_t part = std::min(size, m_blockSize - m_block.size());
+		m_block.append(data, part);
+		data += part;
+		size -= part;
+		if (m_block.size() == m_blockSize && !SubmitBlock())
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool GzipSink::Flush()
+{
+	bool isOk = m_block.empty() || SubmitBlock();
+	while (!m_pending.empty())
+	{
+		isOk &= WriteFront();
+	}
+
+	return m_out.Flush() && isOk;
+}
+
+bool GzipSink::SubmitBlock()
+{
+	std::unique_ptr<Pending> pending(new Pending);
+	pending->m_text.swap(m_block);
+	m_block.reserve(m_blockSize);
+
+	Pending *pBlock = pending.get();
+	int level = m_level;
+	if (m_pool)
+	{
+		pending->m_done = m_pool->Submit([pBlock, level]()
+		{
+			pBlock->m_isCompressed = Compress(pBlock->m_text, level, pBlock->m_compressed);
+		});
+	}
+	else
+	{
+		pBlock->m_isCompressed = Compress(pBlock->m_text, level, pBlock->m_compressed);
+	}
+	m_pending.push_back(std::move(pending));
+
+	// only a window of blocks is in compression at once (a block is written when the window is full)
+	size_t window = m_pool ? 2 * m_pool->GetNumThreads() : 0;
+	bool isOk = true;
+	while (m_pending.size() > window)
+	{
+		isOk &= WriteFront();
+	}
+
+	return isOk;
+}
+
+bool GzipSink::WriteFront()
+{
+	std::unique_ptr<Pending> pending = std::move(m_pending.front());
+	m_pending.pop_front();
+	if (pending->m_done.valid())
+	{
+		pending->m_done.get();
+	}
+	if (!pending->m_isCompressed || !m_out.Write(pending->m_compressed.data(), pending->m_compressed.size()))
+	{
+		return false;
+	}
+
+	Block block;
+	block.m_offset = m_offset;
+	block.m_compressedOffset = m_compressedOffset;
+	block.m_size = static_cast<uint32_t>(pending->m_text.size());
+	block.m_compressedSize = static_cast<uint32_t>(pending->m_compressed.size());
+	m_index.push_back(block);
+	m_offset += block.m_size;
+	m_compressedOffset += block.m_compressedSize;
+	return true;
+}
+
+bool GzipSink::Compress(const std::string& text, int level, std::string& compressed)
+{
+	z_stream stream = {};
+	if (deflateInit2(&stream, level, Z_DEFLATED, s_gzipWindowBits, s_memLevel, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		return false;
+	}
+
+	// the bound of the whole block is allocated so the block is compressed by a single call
+	compressed.resize(deflateBound(&stream, static_cast<uLong>(text.size())));
+	stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(text.data()));
+	stream.avail_in = static_cast<uInt>(text.size());
+	stream.next_out = reinterpret_cast<Bytef *>(&compressed[0]);
+	stream.avail_out = static_cast<uInt>(compressed.size());
+	int result = deflate(&stream, Z_FINISH);
+	compressed.resize(stream.total_out);
+	deflateEnd(&stream);
+
+	return Z_STREAM_END == result;
+}
+
+bool GzipSink::WriteIndex(OutputSink& sink) const
+{
+	std::string line;
+	for (const auto& block : m_index)
+	{
+		line = std::to_string(block.m_offset) + " " + std::to_string(block.m_compressedOffset) + " "
+			+ std::to_string(block.m_size) + " " + std::to_string(block.m_compressedSize) + "\n";
+		if (!sink.Write(line.data(), line.size()))
+		{
+			return false;
+		}
+	}
+
+	return sink.Flush();
+}
+
+bool GzipSink::ReadIndex(FILE *fptr, std::vector<Block>& index)
+{
+	index.clear();
+	unsigned long long offset, compressedOffset;
+	unsigned long size, compressedSize;
+	int numRead;
+	while ((numRead = fscanf(fptr, "%llu %llu %lu %lu", &offset, &compressedOffset, &size, &compressedSize)) == 4)
+	{
+		index.push_back(Block{ offset, compressedOffset, static_cast<uint32_t>(size), static_cast<uint32_t>(compressedSize) });
+	}
+
+	return EOF == numRead;
+}
+
+bool GzipSink::ReadBlock(FILE *fptr, const Block& block, std::string& text)
+{
+	std::string compressed(block.m_compressedSize, '\0');
+#ifdef _WIN32
+	bool isSeek = _fseeki64(fptr, static_cast<long long>(block.m_compressedOffset), SEEK_SET) == 0;
+#else
+	bool isSeek = fseeko(fptr, static_cast<off_t>(block.m_compressedOffset), SEEK_SET) == 0;
+#endif
+	if (!isSeek || fread(&compressed[0], 1, compressed.size(), fptr) != compressed.size())
+	{
+		return false;
+	}
+
+	z_stream stream = {};
+	if (inflateInit2(&stream, s_gzipWindowBits) != Z_OK)
+	{
+		return false;
+	}
+
+	text.resize(block.m_size);
+	stream.next_in = reinterpret_cast<Bytef *>(&compressed[0]);
+	stream.avail_in = static_cast<uInt>(compressed.size());
+	stream.next_out = reinterpret_cast<Bytef *>(&text[0]);
+	stream.avail_out = static_cast<uInt>(text.size());
+	int result = inflate(&stream, Z_FINISH);
+	bool isOk = Z_STREAM_END == result && stream.total_out == block.m_size;
+	inflateEnd(&stream);
+
+	return isOk;
+}
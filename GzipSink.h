@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <future>
+
+#include "OutputSink.h"
+#include "ThreadPool.h"
+
+//	sink that compresses the text to gzip on its way to another sink.
+//	the text is cut to blocks and each block is compressed independently to a gzip member (the members one after the
+//	other are a single gzip file for gunzip and zlib), so the blocks are compressed in parallel on a pool of workers
+//	and a block can be decompressed alone: the index keeps the offset of each block in the text and in the compressed file.
+//	a block ends when it is full or when the sink is flushed
+class GzipSink : public OutputSink
+{
+public:
+	static const size_t s_defaultBlockSize = 1 << 20;
+	static const int s_defaultLevel = 6;
+
+	// location of a block in the text and in the compressed output
+	struct Block
+	{
+		uint64_t m_offset;
+		uint64_t m_compressedOffset;
+		uint32_t m_size;
+		uint32_t m_compressedSize;
+	};
+
+	// with threads > 1 the blocks are compressed on a pool of the sink (otherwise by the thread that writes)
+	explicit GzipSink(OutputSink& out, size_t threads = 1, int level = s_defaultLevel, size_t blockSize = s_defaultBlockSize);
+	// flush the rest of the text (call Flush before to check for errors)
+	~GzipSink() override;
+	GzipSink(const GzipSink&) = delete;
+	GzipSink& operator=(const GzipSink&) = delete;
+
+	// compress the text that was not compressed yet as a block, write all the blocks and flush the output
+	bool Flush() override;
+
+	// the blocks that were written to the output (in the order of the text)
+	const std::vector<Block>& GetIndex() const { return m_index; }
+	uint64_t GetCompressedBytes() const { return m_compressedOffset; }
+
+	// write the index as a line "offset compressedOffset size compressedSize" for each block
+	bool WriteIndex(OutputSink& sink) const;
+	// read an index written by WriteIndex. returns false if the file is not an index
+	static bool ReadIndex(FILE *fptr, std::vector<Block>& index);
+	// read the text of a single block from the compressed file (seek to the block and decompress its member)
+	static bool ReadBlock(FILE *fptr, const Block& block, std::string& text);
+
+protected:
+	bool WriteIMP(const char *data, size_t size) override;
+
+private:
+	// a block that is compressed (its text is kept until the block is written)
+	struct Pending
+	{
+		std::string m_text;
+		std::string m_compressed;
+		bool m_isCompressed = false;
+		std::future<void> m_done;
+	};
+
+	OutputSink& m_out;
+	int m_level;
+	size_t m_blockSize;
+	// workers for parallel compression (exists only with more than 1 thread)
+	std::unique_ptr<ThreadPool> m_pool;
+	// text of the current block
+	std::string m_block;
+	// blocks in compression in the order of the text (at most a window of blocks so the memory stays bounded)
+	std::deque<std::unique_ptr<Pending>> m_pending;
+	std::vector<Block> m_index;
+	uint64_t m_offset;
+	uint64_t m_compressedOffset;
+
+	// compress the current block (on the pool when there is a pool)
+	bool SubmitBlock();
+	// wait for the first block in compression and write it to the output
+	bool WriteFront();
+	// compress text to a single gzip member
+	static bool Compress(const std::string& text, int level, std::string& compressed);
+};
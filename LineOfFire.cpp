@@ -0,0 +1,40 @@
+#include "LineOfFire.h"
+
+LineOfFire::LineOfFire(const GridTopology& topology, const std::vector<int>& shelters, size_t range)
+: m_numCells(topology.GetNumCells())
+, m_rayOffsets()
+, m_rayCells()
+, m_canHit(topology.GetNumCells() * topology.GetNumCells(), 0)
+{
+	std::vector<bool> isShelter(m_numCells, false);
+	for (int shelter : shelters)
+	{
+		// a shelter outside the grid is never reached
+		if (shelter >= 0 && static_cast<size_t>(shelter) < m_numCells)
+		{
+			isShelter[shelter] = true;
+		}
+	}
+
+	m_rayOffsets.reserve(m_numCells * NUM_DIRECTIONS + 1);
+	for (int cell = 0; cell < static_cast<int>(m_numCells); ++cell)
+	{
+		for (int d = 0; d < NUM_DIRECTIONS; ++d)
+		{
+			m_rayOffsets.push_back(static_cast<uint32_t>(m_rayCells.size()));
+			if (DIR_STAY == d)
+			{
+				continue;
+			}
+
+			int shot = topology.GetNeighbor(cell, static_cast<GridDirection>(d));
+			for (size_t i = 0; i < range && GridTopology::s_invalidCell != shot && !isShelter[shot]; ++i)
+			{
+				m_rayCells.push_back(shot);
+				m_canHit[cell * m_numCells + shot] = 1;
+				shot = topology.GetNeighbor(shot, static_cast<GridDirection>(d));
+			}
+		}
+	}
+	m_rayOffsets.push_back(static_cast<uint32_t>(m_rayCells.size()));
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "GridTopology.h"
+
+//	precalculated shots of a single attack range in the grid.
+//	the ray of a (cell, direction) is the ordered cells a shot from the cell passes until the range ends, the grid ends
+//	or the shot reaches a shelter (the shelter and the cells behind it are not in the ray).
+//	a cell can hit another cell if the other cell is in one of the rays of the cell
+class LineOfFire
+{
+public:
+	LineOfFire() = default;
+	// shelters are the cells of the shelters
+	LineOfFire(const GridTopology& topology, const std::vector<int>& shelters, size_t range);
+	~LineOfFire() = default;
+
+	// cells of the ray of cell in direction are [RayBegin, RayEnd). the ray of DIR_STAY is empty
+	const int *RayBegin(int cell, GridDirection direction) const { return m_rayCells.data() + m_rayOffsets[cell * NUM_DIRECTIONS + direction]; }
+	const int *RayEnd(int cell, GridDirection direction) const { return m_rayCells.data() + m_rayOffsets[cell * NUM_DIRECTIONS + direction + 1]; }
+
+	// true if a shot from cell can hit target
+	bool CanHit(int cell, int target) const { return 0 != m_canHit[cell * m_numCells + target]; }
+
+private:
+	size_t m_numCells = 0;
+	// start of the ray of each (cell, direction) in m_rayCells (NUM_DIRECTIONS for each cell and the end of the last ray)
+	std::vector<uint32_t> m_rayOffsets;
+	std::vector<int> m_rayCells;
+	// numCells x numCells
+	std::vector<uint8_t> m_canHit;
+};
@@ -0,0 +1,202 @@
+#include "ModelEstimate.h"
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#include "GridTopology.h"
+
+// the constants are calibrated on the scenarios of pomdp_bench (single thread, counting sink, see benchmark_baseline.json)
+
+// an end-state of two objects that moved to the same cell is merged with another end-state (the object returns to its
+// origin). each additional moving object keeps (1 - s_collision / cells) of the lines
+static const double s_collision = 2.7;
+// seconds of each move of the objects (correcting the collisions, ranking and merging the end-state)
+static const double s_secondsPerMove = 1.5e-7;
+// seconds of each observation line (the observations are enumerated by recursion for each state)
+static const double s_secondsPerObservation = 7.3e-8;
+// seconds of each byte of the text (formatting and writing)
+static const double s_secondsPerByte = 1.7e-9;
+// memory of the process before saving
+static const double s_baseMemory = 4.0 * 1024 * 1024;
+// bytes of a move of an object in the table of the moves (location and probability)
+static const double s_bytesPerMove = sizeof(int) + sizeof(double);
+// bytes of an entry of the transitions that are kept for the pruning (column and value)
+static const double s_bytesPerEntry = sizeof(uint32_t) + sizeof(double);
+// length of the shortest text of a probability
+static const double s_shortestLength = 18.0;
+// length of a start probability that is not 0 (10 significant digits and the separator)
+static const double s_startLength = 15.0;
+// text that does not grow with the states (comments, actions, discount and rewards)
+static const double s_fixedBytes = 1024.0;
+
+// n * (n - 1) * ... * (n - k + 1) or UINT64_MAX when it is too large
+static uint64_t Permutations(uint64_t n, size_t k)
+{
+	if (k > n)
+	{
+		return 0;
+	}
+
+	uint64_t result = 1;
+	for (size_t i = 0; i < k; ++i)
+	{
+		if (result > UINT64_MAX / (n - i))
+		{
+			return UINT64_MAX;
+		}
+		result *= n - i;
+	}
+
+	return result;
+}
+
+static double PermutationsDouble(double n, size_t k)
+{
+	double result = 1.0;
+	for (size_t i = 0; i < k; ++i)
+	{
+		result *= std::max(n - i, 0.0);
+	}
+
+	return result;
+}
+
+// average number of digits of 0, 1, ..., count - 1
+static double AverageDigits(double count)
+{
+	if (count < 1.0)
+	{
+		return 1.0;
+	}
+
+	double total = 0.0;
+	double low = 0.0;
+	for (double high = 10.0, digits = 1.0; low < count; low = high, high *= 10.0, digits += 1.0)
+	{
+		total += (std::min(high, count) - low) * digits;
+	}
+
+	return total / count;
+}
+
+// average number of other cells of a row (or a column) of the grid in range of a cell
+static double AverageCellsInRange(double gridSize, double range)
+{
+	// sum over the cells x of the row of min(x, range) (the cells before x in range), the cells after x are the same
+	double last = gridSize - 1;
+	double sum = range >= last ? gridSize * last / 2 : range * (range + 1) / 2 + range * (last - range);
+	return 2 * sum / gridSize;
+}
+
+ModelEstimate ModelEstimate::Calc(const Scenario& scenario)
+{
+	ModelEstimate estimate;
+	double g = static_cast<double>(scenario.m_gridSize);
+	uint64_t numCells = static_cast<uint64_t>(scenario.m_gridSize) * scenario.m_gridSize;
+	double cells = static_cast<double>(numCells);
+	size_t numObjects = 2 + scenario.m_numNonInvolved;
+	if (0 == numCells || numObjects > numCells)
+	{
+		return estimate;
+	}
+
+	// live states: the objects in different cells, dead states: the same without the enemy
+	estimate.m_numLive = Permutations(numCells, numObjects);
+	estimate.m_numDead = Permutations(numCells, numObjects - 1);
+	bool isOverflow = UINT64_MAX == estimate.m_numLive || UINT64_MAX - estimate.m_numLive < estimate.m_numDead + 2;
+	estimate.m_numStates = isOverflow ? UINT64_MAX : estimate.m_numLive + estimate.m_numDead + 2;
+	estimate.m_numObservations = isOverflow ? UINT64_MAX : estimate.m_numLive + estimate.m_numDead;
+	double live = PermutationsDouble(cells, numObjects);
+	double dead = PermutationsDouble(cells, numObjects - 1);
+
+	// rows of the moves: stay and each move of the robot that stays in the grid (fanout is 1 + the average neighbors of a cell)
+	double fanout = 1 + 4 * (g - 1) / g;
+	double moveRows = (live + dead) * fanout;
+	// lines of a row: the moves of the objects except the robot (the enemy doesn't move when it is dead) merged by the collisions
+	double keep = std::max(0.0, 1 - s_collision / cells);
+	double movingLive = static_cast<double>(numObjects - 1);
+	double movingDead = static_cast<double>(numObjects - 2);
+	double linesLive = std::pow(fanout, movingLive) * std::pow(keep, std::max(movingLive - 1, 0.0));
+	double linesDead = std::pow(fanout, movingDead) * std::pow(keep, std::max(movingDead - 1, 0.0));
+	// a robot that moves to the target has a single line to win
+	double pTarget = scenario.m_isTargetInGrid ? 1 / cells : 0.0;
+	// a robot in the line of fire of the live enemy has a line to loss
+	double pFire = 2 * AverageCellsInRange(g, static_cast<double>(scenario.m_enemyRange)) / (cells - 1);
+	double moveLines = fanout * (live * ((1 - pTarget) * linesLive + pTarget + pFire) + dead * ((1 - pTarget) * linesDead + pTarget));
+
+	// rows of the shots: each object in range of the robot in a direction (the shots are only with live enemy).
+	// a hit adds a line to win or loss to the moves of the miss
+	double shotRows = live * (numObjects - 1) * 2 * AverageCellsInRange(g, static_cast<double>(scenario.m_selfRange)) / (cells - 1);
+	double shotLines = shotRows * (linesLive + 1);
+
+	// each observation of a state has the robot in its cell (all the observations of the block of the state)
+	double observationLines = live * (live / cells) + dead * (dead / cells);
+	estimate.m_transitionLines = moveLines + shotLines;
+	estimate.m_observationLines = observationLines;
+
+	// length of the names of the states and the observations (the robot and the objects as numbers separated by 'x')
+	double nameLive;
+	double nameDead;
+	if (scenario.m_isIndexed)
+	{
+		nameLive = nameDead = AverageDigits(live + dead + 2);
+	}
+	else
+	{
+		double digits = AverageDigits(cells);
+		nameLive = 1 + (numObjects - 1) + numObjects * digits;
+		nameDead = 1 + (numObjects - 1) + (numObjects - 1) * digits + 1;
+	}
+	double name = (live * nameLive + dead * nameDead) / (live + dead);
+	double probability = scenario.m_precision < 0 ? s_shortestLength : scenario.m_precision + 2.0;
+	// "<section>: <action> : <state> : <end> <p>\n" and an empty line after each row
+	double separators = 3 + 3 + 3 + 1 + 1;
+	double moveAction = scenario.m_isIndexed ? 1.0 : (1 + (fanout - 1) * 4.5) / fanout;
+	double shotAction = scenario.m_isIndexed ? 1.0 : 10.5;
+	double lineBytes = separators + 2 * name + probability;
+	double textBytes = moveLines * (lineBytes + moveAction) + moveRows
+		+ shotLines * (lineBytes + shotAction) + shotRows
+		+ observationLines * (lineBytes + 1) + (live + dead);
+	// names of the states and the observations (only without idx) and the start probability of each state
+	double namesBytes = scenario.m_isIndexed ? 0.0 : 2 * (live * (nameLive + 1) + dead * (nameDead + 1));
+	double startBytes = live * s_startLength + (dead + 2) * 2;
+	estimate.m_bytes = textBytes + namesBytes + startBytes + s_fixedBytes;
+
+	// the moves of the objects are calculated for all the directions of each object (a move out of the grid stays), so the rows
+	// calculate more moves than lines. the table of the moves keeps the moves from each configuration of the objects except the robot
+	double movesLive = std::pow(static_cast<double>(NUM_DIRECTIONS), movingLive);
+	double movesDead = std::pow(static_cast<double>(NUM_DIRECTIONS), movingDead);
+
+	// the table of the moves, a row of observations of a robot cell for each shard in the window of the pool,
+	// and the transitions of all the actions for the pruning
+	double movesMemory = (live + dead + 1) * sizeof(size_t) + s_bytesPerMove * movingLive
+		* (PermutationsDouble(cells, numObjects - 1) * movesLive + PermutationsDouble(cells, numObjects - 2) * movesDead);
+	double threads = static_cast<double>(std::max<size_t>(scenario.m_threads, 1));
+	double shardMemory = threads > 1 ? 2 * threads * observationLines * (lineBytes + 1) / cells : 0.0;
+	double pruneMemory = scenario.m_isPruned ? estimate.m_transitionLines * s_bytesPerEntry + moveRows * sizeof(uint64_t) : 0.0;
+	estimate.m_peakMemoryBytes = s_baseMemory + movesMemory + shardMemory + pruneMemory;
+
+	// the moves and the observations are calculated in parallel, the bytes are written by a single thread
+	double calcSeconds = (moveRows * (live * movesLive + dead * movesDead) / (live + dead) + shotRows * movesLive) * s_secondsPerMove
+		+ observationLines * s_secondsPerObservation;
+	estimate.m_seconds = (scenario.m_isPruned ? 2 : 1) * calcSeconds / std::min(threads, cells) + estimate.m_bytes * s_secondsPerByte;
+
+	return estimate;
+}
+
+// a number that may be above 64 bits
+static std::string NumberJson(double value)
+{
+	char text[32];
+	snprintf(text, sizeof(text), "%.6g", value);
+	return text;
+}
+
+std::string ModelEstimate::ToJson() const
+{
+	return "{\"states\": " + std::to_string(m_numStates) + ", \"live\": " + std::to_string(m_numLive) + ", \"dead\": " + std::to_string(m_numDead)
+		+ ", \"observations\": " + std::to_string(m_numObservations) + ", \"transitionLines\": " + NumberJson(m_transitionLines)
+		+ ", \"observationLines\": " + NumberJson(m_observationLines) + ", \"bytes\": " + NumberJson(m_bytes)
+		+ ", \"peakMemoryBytes\": " + NumberJson(m_peakMemoryBytes) + ", \"seconds\": " + NumberJson(m_seconds) + "}\n";
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//	estimate of the size and the cost of the pomdp text of a scenario before it is written (see POMDP_Writer::EstimateModel).
+//	the numbers of states and observations are exact. the lines, the bytes, the memory and the time are estimated in closed form
+//	from the grid size, the number of objects and the ranges (no state is enumerated), with constants calibrated on the
+//	benchmark scenarios (pomdp_bench). the estimate takes microseconds for any scenario
+struct ModelEstimate
+{
+	// the parameters of the scenario that the size of the model depends on
+	struct Scenario
+	{
+		size_t m_gridSize = 0;
+		size_t m_numNonInvolved = 0;
+		// range of the shots of the enemy and of the robot (the shelters are ignored)
+		size_t m_enemyRange = 0;
+		size_t m_selfRange = 0;
+		// a robot that moves to the target goes to win (a single line instead of the moves of the objects)
+		bool m_isTargetInGrid = true;
+		bool m_isIndexed = false;
+		int m_precision = 6;
+		// the text is calculated once more for the pruning (the estimate is for all the states)
+		bool m_isPruned = false;
+		size_t m_threads = 1;
+	};
+
+	static ModelEstimate Calc(const Scenario& scenario);
+
+	// exact counts (UINT64_MAX when the count is too large for 64 bits)
+	uint64_t m_numLive = 0;
+	uint64_t m_numDead = 0;
+	// live and dead states, win and loss
+	uint64_t m_numStates = 0;
+	uint64_t m_numObservations = 0;
+
+	// estimates (double so scenarios with counts above 64 bits can be estimated and rejected)
+	double m_transitionLines = 0.0;
+	double m_observationLines = 0.0;
+	double m_bytes = 0.0;
+	double m_peakMemoryBytes = 0.0;
+	double m_seconds = 0.0;
+
+	std::string ToJson() const;
+};
@@ -0,0 +1,1167 @@
+//	tests of the models of the writer (run by ctest): on small grids the text of SaveInFormat, the binary model of SaveBinary
+//	and the model in memory of BuildModel must be the same model (with and without reachable pruning and symmetry reduction),
+//	the text with threads must be the same bytes as the text of a single thread, and BeliefFilter must be the bayes update
+//	of the model in memory.
+//	StateIndexer must rank and unrank every state of the text, and objects that are not valid states are reported as errors.
+//	the text with idx is the text with names, every end-state of the text with names is declared, and the moves that end in
+//	a taken location are corrected by the rules of the game (see POMDP_Writer.h). an object with std 0 starts in its cell.
+//	the transitions with the symmetries of the grid are the transitions without them, and the text doesn't use the symmetries.
+//	the pruned model has exactly the states reached from the start, with the same rows. the section cache calculates again only
+//	the sections whose inputs were changed, and the text from the cache is the text without the cache. a scenario of the batch
+//	that is not valid is an error of its own and the other scenarios are written. the statistics of a save count the text
+//	that was written (the same with threads) and a failed write is reported in the statistics. the exact counts of the estimate
+//	are the counts of the text and the estimated lines and bytes are close to the counters. the gzip of the text is the text for
+//	gunzip and each block of its index is the part of the text at the offset of the block. the value of the solver is between
+//	the blind policy and qmdp, and its vectors are the same with threads and in the .alpha text.
+//
+//	usage: pomdp_tests (returns the number of failed checks)
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#include "POMDP_Writer.h"
+#include "BinaryModelReader.h"
+#include "BeliefFilter.h"
+#include "TextFormat.h"
+#include "BatchGenerator.h"
+#include "GzipSink.h"
+#include "PerseusSolver.h"
+
+#include <zlib.h>
+
+// probabilities of the text are written with the shortest digits, so only the order of the sums can differ
+static const double s_tolerance = 1e-12;
+
+// binary model, section cache and scenarios of the batch written by the tests (in the working directory of ctest)
+static const char *s_binaryName = "pomdp_tests.bin";
+static const char *s_cacheName = "pomdp_tests_cache";
+static const char *s_gzipNames[] = { "pomdp_tests.gz", "pomdp_tests.gz.idx" };
+static const char *s_batchNames[] = { "pomdp_tests_batch.POMDP", "pomdp_tests_invalid.POMDP", "pomdp_tests_grid1.POMDP" };
+
+static int s_failed = 0;
+
+static void Check(bool isPassed, const std::string& name)
+{
+	if (!isPassed)
+	{
+		std::cerr << "FAIL " << name << "\n";
+		++s_failed;
+	}
+}
+
+// sparse row: end-state (or observation) -> probability
+typedef std::map<size_t, double> row_t;
+
+// the model of the text of SaveInFormat with idx (repeated end-states of a row are summed)
+struct TextModel
+{
+	size_t m_numStates = 0;
+	size_t m_numActions = 0;
+	size_t m_numObservations = 0;
+	// rows of each action ([numActions]) and the rows of all actions ("*")
+	std::vector<std::map<size_t, row_t>> m_transitions;
+	std::map<size_t, row_t> m_allActions;
+	std::map<size_t, row_t> m_observations;
+	std::vector<double> m_rewards;
+	std::vector<double> m_start;
+
+	// the rows of an action replace the rows of all actions
+	const row_t *GetRow(size_t action, size_t state) const
+	{
+		auto itr = m_transitions[action].find(state);
+		if (itr != m_transitions[action].end())
+		{
+			return &itr->second;
+		}
+		auto all = m_allActions.find(state);
+		return all != m_allActions.end() ? &all->second : nullptr;
+	}
+};
+
+static bool ParseText(const std::string& text, TextModel& model)
+{
+	std::istringstream in(text);
+	std::string line;
+	double defaultReward = 0.0;
+	std::map<size_t, double> rewards;
+	while (std::getline(in, line))
+	{
+		std::istringstream words(line);
+		std::string word, action, colon;
+		size_t state, end;
+		double p;
+		words >> word;
+		if ("states:" == word)
+		{
+			words >> model.m_numStates;
+		}
+		else if ("actions:" == word)
+		{
+			words >> model.m_numActions;
+			model.m_transitions.resize(model.m_numActions);
+		}
+		else if ("observations:" == word)
+		{
+			words >> model.m_numObservations;
+		}
+		else if ("start:" == word)
+		{
+			// the probability of every state in the next line
+			model.m_start.resize(model.m_numStates);
+			for (auto & start : model.m_start)
+			{
+				in >> start;
+			}
+		}
+		else if ("T:" == word && words >> action >> colon >> state >> colon >> end >> p)
+		{
+			row_t& row = "*" == action ? model.m_allActions[state] : model.m_transitions[std::stoul(action)][state];
+			row[end] += p;
+		}
+		else if ("O:" == word && words >> action >> colon >> state >> colon >> end >> p)
+		{
+			model.m_observations[state][end] += p;
+		}
+		else if ("R:" == word)
+		{
+			// R: * : <state or *> : * : * <reward>
+			std::string stateWord;
+			words >> action >> colon >> stateWord >> colon >> word >> colon >> word >> p;
+			if ("*" == stateWord)
+			{
+				defaultReward = p;
+			}
+			else
+			{
+				rewards[std::stoul(stateWord)] = p;
+			}
+		}
+	}
+
+	model.m_rewards.assign(model.m_numStates, defaultReward);
+	for (const auto& reward : rewards)
+	{
+		model.m_rewards[reward.first] = reward.second;
+	}
+
+	return model.m_numStates > 0 && model.m_numActions > 0 && model.m_start.size() == model.m_numStates;
+}
+
+static bool IsSameRow(const row_t& expected, const row_t& actual)
+{
+	row_t all = expected;
+	for (const auto& entry : actual)
+	{
+		all[entry.first];
+	}
+	for (const auto& entry : all)
+	{
+		auto e = expected.find(entry.first);
+		auto a = actual.find(entry.first);
+		double pExpected = e == expected.end() ? 0.0 : e->second;
+		double pActual = a == actual.end() ? 0.0 : a->second;
+		if (std::abs(pExpected - pActual) > s_tolerance)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template <typename Matrix>
+static double MatrixValue(const Matrix& matrix, size_t row, size_t column)
+{
+	double p = 0.0;
+	for (uint64_t k = matrix.m_rowOffsets[row]; k < matrix.m_rowOffsets[row + 1]; ++k)
+	{
+		p += matrix.m_columns[k] == column ? matrix.m_values[k] : 0.0;
+	}
+
+	return p;
+}
+
+template <typename Matrix>
+static row_t MatrixRow(const Matrix& matrix, size_t row)
+{
+	row_t result;
+	for (uint64_t k = matrix.m_rowOffsets[row]; k < matrix.m_rowOffsets[row + 1]; ++k)
+	{
+		result[matrix.m_columns[k]] += matrix.m_values[k];
+	}
+
+	return result;
+}
+
+// a scenario of the tests: grid 3 with a non-involved object, and a shelter when the target is not in the center
+// (with the target in the center all the symmetries of the grid are kept)
+struct TestScenario
+{
+	std::string m_name;
+	size_t m_idxTarget;
+	bool m_isShelter;
+};
+
+static std::unique_ptr<POMDP_Writer> CreateWriter(const TestScenario& scenario)
+{
+	Point locSelf(0, 0, 0.4);
+	Move_Properties mSelf(0.2);
+	Self_Obj self(locSelf, mSelf, 1, 0.6, 2, 0.75);
+	Point locEnemy(2, 2, 0.9);
+	Move_Properties mEnemy(0.3);
+	Attack_Obj enemy(locEnemy, mEnemy, 1, 0.5);
+	std::unique_ptr<POMDP_Writer> writer(new POMDP_Writer(3, self, enemy));
+
+	Point locNonInvolved(1, 0, 0.3);
+	Move_Properties mNonInvolved(0.5);
+	Movable_Obj nonInvolved(locNonInvolved, mNonInvolved);
+	writer->AddObj(nonInvolved);
+	if (scenario.m_isShelter)
+	{
+		Point locShelter(0, 2);
+		ObjInGrid shelter(locShelter);
+		writer->AddObj(shelter);
+	}
+
+	writer->SetIndexedOutput(true);
+	writer->SetPrecision(TextFormat::s_shortest);
+	return writer;
+}
+
+static std::string SaveText(POMDP_Writer& writer, size_t idxTarget, size_t threads)
+{
+	MemorySink sink;
+	GenerationStats stats = writer.SaveInFormat(sink, idxTarget, threads);
+	return stats.IsFailed() ? std::string() : sink.GetData();
+}
+
+// text, binary and model in memory of a scenario with the settings are the same model
+static void TestSameModel(const TestScenario& scenario, bool isPruned, bool isSymmetric)
+{
+	std::string name = scenario.m_name + (isPruned ? " pruned" : "") + (isSymmetric ? " symmetric" : "");
+	std::unique_ptr<POMDP_Writer> writer = CreateWriter(scenario);
+	writer->SetReachablePruning(isPruned);
+	writer->SetSymmetryReduction(isSymmetric);
+
+	TextModel text;
+	Check(ParseText(SaveText(*writer, scenario.m_idxTarget, 1), text), name + ": text");
+
+	FILE *fptr = fopen(s_binaryName, "wb");
+	Check(nullptr != fptr && writer->SaveBinary(fptr, scenario.m_idxTarget) > 0, name + ": binary written");
+	if (nullptr != fptr)
+	{
+		fclose(fptr);
+	}
+	BinaryModelReader binary;
+	bool isOpen = binary.Open(s_binaryName);
+	Check(isOpen, name + ": binary opened");
+
+	PomdpModel<double> model = writer->BuildModel<double>(scenario.m_idxTarget);
+	if (!isOpen || text.m_numStates != model.GetNumStates() || text.m_numActions != model.GetNumActions()
+		|| text.m_numObservations != model.GetNumObservations() || binary.GetNumStates() != model.GetNumStates()
+		|| binary.GetNumActions() != model.GetNumActions())
+	{
+		Check(false, name + ": sizes");
+		binary.Close();
+		remove(s_binaryName);
+		return;
+	}
+
+	size_t numStates = model.GetNumStates();
+	for (size_t a = 0; a < model.GetNumActions(); ++a)
+	{
+		bool isSame = true;
+		for (size_t s = 0; s < numStates && isSame; ++s)
+		{
+			const row_t *textRow = text.GetRow(a, s);
+			row_t modelRow = MatrixRow(model.m_transitions[a], s);
+			isSame = IsSameRow(nullptr == textRow ? row_t() : *textRow, modelRow) && IsSameRow(MatrixRow(binary.GetTransitions(a), s), modelRow);
+		}
+		Check(isSame, name + ": transitions of action " + std::to_string(a));
+	}
+
+	// the binary model has all the observations (its observations are the model's only without pruning)
+	bool isSameObservations = true;
+	for (size_t s = 0; s < numStates && isSameObservations; ++s)
+	{
+		row_t modelRow = MatrixRow(model.m_observations, s);
+		auto textRow = text.m_observations.find(s);
+		isSameObservations = IsSameRow(textRow == text.m_observations.end() ? row_t() : textRow->second, modelRow);
+		for (size_t o = 0; o < model.GetNumObservations() && isSameObservations && !isPruned; ++o)
+		{
+			auto itr = modelRow.find(o);
+			double p = itr == modelRow.end() ? 0.0 : itr->second;
+			isSameObservations = std::abs(binary.GetObservationProbability(s, o) - p) <= s_tolerance;
+		}
+	}
+	Check(isSameObservations, name + ": observations");
+
+	bool isSameVectors = true;
+	for (size_t s = 0; s < numStates; ++s)
+	{
+		isSameVectors &= text.m_rewards[s] == model.m_rewards[s] && binary.GetRewards()[s] == model.m_rewards[s];
+		isSameVectors &= std::abs(text.m_start[s] - model.m_start[s]) <= s_tolerance && binary.GetStart()[s] == model.m_start[s];
+	}
+	Check(isSameVectors, name + ": rewards and start");
+
+	binary.Close();
+	remove(s_binaryName);
+}
+
+// sink that fails every write
+class FailingSink : public OutputSink
+{
+protected:
+	bool WriteIMP(const char *, size_t) override { return false; }
+};
+
+// the counters of the statistics are the lines and the rows of the text (the same with threads), the report is the json of
+// the statistics, and a failed write is the error of the statistics
+static void TestStats(const TestScenario& scenario)
+{
+	std::string name = scenario.m_name + ": stats";
+	std::unique_ptr<POMDP_Writer> writer = CreateWriter(scenario);
+	MemorySink report;
+	writer->SetStatsReport(&report);
+	MemorySink sink;
+	GenerationStats stats = writer->SaveInFormat(sink, scenario.m_idxTarget, 1);
+	writer->SetStatsReport(nullptr);
+
+	// lines of T: and O: without the wildcard and the rows of the observations (a row of each live and dead state)
+	std::istringstream text(sink.GetData());
+	uint64_t numLines = 0;
+	for (std::string line; std::getline(text, line);)
+	{
+		numLines += (0 == line.compare(0, 3, "T: ") || 0 == line.compare(0, 3, "O: ")) && std::string::npos == line.find("* : * : *");
+	}
+	uint64_t sectionBytes = 0;
+	for (const auto& section : stats.m_sections)
+	{
+		sectionBytes += section.m_bytes;
+	}
+	const GenerationStats::Counters& observations = stats.m_sections[GenerationStats::SECTION_OBSERVATIONS].m_counters;
+	Check(!stats.IsFailed() && stats.m_bytesWritten == sink.GetData().size() && sectionBytes <= stats.m_bytesWritten
+		&& 1 == stats.m_threads && 0 == stats.m_peakBufferSize, name + " of the save");
+	Check(stats.GetTotalCounters().m_lines == numLines && observations.m_rows == StateIndexer(3, 3).NumStates() - 2, name + ": lines and rows");
+	Check(report.GetData() == stats.ToJson() && std::string::npos == report.GetData().find("\"error\""), name + ": report");
+
+	GenerationStats threads = writer->SaveInFormat(sink, scenario.m_idxTarget, 4);
+	bool isSameCounters = 4 == threads.m_threads && threads.m_peakBufferSize > 0;
+	for (int s = 0; s < GenerationStats::NUM_SECTIONS; ++s)
+	{
+		const GenerationStats::Counters& single = stats.m_sections[s].m_counters;
+		const GenerationStats::Counters& parallel = threads.m_sections[s].m_counters;
+		isSameCounters &= single.m_states == parallel.m_states && single.m_rows == parallel.m_rows && single.m_lines == parallel.m_lines
+			&& single.m_mapInsertions == parallel.m_mapInsertions && stats.m_sections[s].m_bytes == threads.m_sections[s].m_bytes;
+	}
+	Check(isSameCounters, name + " with 4 threads");
+
+	FailingSink failing;
+	GenerationStats failed = writer->SaveInFormat(failing, scenario.m_idxTarget, 1);
+	Check(failed.IsFailed() && std::string::npos != failed.ToJson().find("\"error\": \"" + failed.m_error + "\""), name + " of a failed write");
+}
+
+// the exact counts of the estimate are the states and the observations of the text, and the estimated lines and bytes are
+// close to the counters of the save (the lines of the observations are exact, the others are calibrated on larger grids)
+static void TestEstimate(const TestScenario& scenario)
+{
+	std::string name = scenario.m_name + ": estimate";
+	std::unique_ptr<POMDP_Writer> writer = CreateWriter(scenario);
+	ModelEstimate estimate = writer->EstimateModel(scenario.m_idxTarget);
+	StateIndexer indexer(3, 3);
+	Check(estimate.m_numLive == indexer.NumLive() && estimate.m_numDead == indexer.NumDead() && estimate.m_numStates == indexer.NumStates()
+		&& estimate.m_numObservations == indexer.NumLive() + indexer.NumDead(), name + ": counts");
+
+	MemorySink sink;
+	GenerationStats stats = writer->SaveInFormat(sink, scenario.m_idxTarget, 1);
+	TextModel text;
+	Check(ParseText(sink.GetData(), text) && estimate.m_numStates == text.m_numStates && estimate.m_numObservations == text.m_numObservations,
+		name + ": counts of the text");
+
+	auto isClose = [](double estimated, uint64_t counted) { return estimated >= 0.75 * counted && estimated <= 1.25 * counted; };
+	uint64_t transitionLines = stats.m_sections[GenerationStats::SECTION_POSITIONS].m_counters.m_lines
+		+ stats.m_sections[GenerationStats::SECTION_HITS].m_counters.m_lines;
+	uint64_t observationLines = stats.m_sections[GenerationStats::SECTION_OBSERVATIONS].m_counters.m_lines;
+	Check(isClose(estimate.m_transitionLines, transitionLines), name + ": transition lines");
+	Check(std::abs(estimate.m_observationLines - observationLines) < 0.5, name + ": observation lines");
+	Check(isClose(estimate.m_bytes, stats.m_bytesWritten), name + ": bytes");
+
+	// objects that are not valid states have no states, and counts above 64 bits are UINT64_MAX
+	ModelEstimate::Scenario invalid;
+	invalid.m_gridSize = 2;
+	invalid.m_numNonInvolved = 3;
+	ModelEstimate::Scenario overflow;
+	overflow.m_gridSize = 10;
+	overflow.m_numNonInvolved = 20;
+	Check(0 == ModelEstimate::Calc(invalid).m_numStates && 0 == ModelEstimate::Calc(invalid).m_transitionLines
+		&& UINT64_MAX == ModelEstimate::Calc(overflow).m_numStates, name + " of scenarios without counts");
+}
+
+// decompress all the gzip members of the data (as gunzip does). returns false if the data is not gzip
+static bool Gunzip(const std::string& compressed, std::string& text)
+{
+	text.clear();
+	z_stream stream = {};
+	if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+	{
+		return false;
+	}
+
+	stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(compressed.data()));
+	stream.avail_in = static_cast<uInt>(compressed.size());
+	char buffer[4096];
+	int result = Z_OK;
+	while (Z_OK == result)
+	{
+		stream.next_out = reinterpret_cast<Bytef *>(buffer);
+		stream.avail_out = sizeof(buffer);
+		result = inflate(&stream, Z_NO_FLUSH);
+		text.append(buffer, sizeof(buffer) - stream.avail_out);
+		// the next member starts after the end of a member
+		if (Z_STREAM_END == result && stream.avail_in > 0)
+		{
+			result = inflateReset(&stream);
+		}
+	}
+	inflateEnd(&stream);
+	return Z_STREAM_END == result && 0 == stream.avail_in;
+}
+
+// the gzip of the text is the text for gunzip (with small blocks so the text is many members, the same bytes with threads),
+// the index covers the text and the compressed file, and each block read through the index is its part of the text
+static void TestGzip(const TestScenario& scenario)
+{
+	std::string name = scenario.m_name + ": gzip";
+	std::unique_ptr<POMDP_Writer> writer = CreateWriter(scenario);
+	std::string text = SaveText(*writer, scenario.m_idxTarget, 1);
+	const size_t blockSize = 4096;
+
+	MemorySink compressed;
+	GzipSink gzipSink(compressed, 1, GzipSink::s_defaultLevel, blockSize);
+	GenerationStats stats = writer->SaveInFormat(gzipSink, scenario.m_idxTarget, 1);
+	MemorySink threadsCompressed;
+	GzipSink threadsSink(threadsCompressed, 4, GzipSink::s_defaultLevel, blockSize);
+	GenerationStats threadsStats = writer->SaveInFormat(threadsSink, scenario.m_idxTarget, 4);
+	std::string gunzipped;
+	Check(!stats.IsFailed() && gzipSink.Flush() && Gunzip(compressed.GetData(), gunzipped) && gunzipped == text, name + " of the text");
+	Check(!threadsStats.IsFailed() && threadsSink.Flush() && threadsCompressed.GetData() == compressed.GetData(), name + " with 4 threads");
+
+	// the blocks one after the other in the text and in the compressed file
+	const std::vector<GzipSink::Block>& index = gzipSink.GetIndex();
+	uint64_t offset = 0;
+	uint64_t compressedOffset = 0;
+	for (const GzipSink::Block& block : index)
+	{
+		bool isNext = block.m_offset == offset && block.m_compressedOffset == compressedOffset && block.m_size <= blockSize;
+		offset = isNext ? offset + block.m_size : UINT64_MAX;
+		compressedOffset += block.m_compressedSize;
+	}
+	Check(index.size() > 1 && offset == text.size() && compressedOffset == compressed.GetData().size()
+		&& gzipSink.GetCompressedBytes() == compressedOffset, name + ": index");
+
+	// the index from its file and the blocks from the compressed file
+	FILE *fptr = fopen(s_gzipNames[1], "w");
+	bool isWritten = nullptr != fptr;
+	if (isWritten)
+	{
+		FileSink indexSink(fptr);
+		isWritten = gzipSink.WriteIndex(indexSink) && indexSink.Flush();
+		fclose(fptr);
+	}
+	std::ofstream(s_gzipNames[0], std::ios::binary) << compressed.GetData();
+	std::vector<GzipSink::Block> readIndex;
+	fptr = fopen(s_gzipNames[1], "r");
+	bool isRead = nullptr != fptr && GzipSink::ReadIndex(fptr, readIndex) && readIndex.size() == index.size();
+	if (nullptr != fptr)
+	{
+		fclose(fptr);
+	}
+	for (size_t i = 0; i < readIndex.size() && isRead; ++i)
+	{
+		isRead = readIndex[i].m_offset == index[i].m_offset && readIndex[i].m_compressedOffset == index[i].m_compressedOffset
+			&& readIndex[i].m_size == index[i].m_size && readIndex[i].m_compressedSize == index[i].m_compressedSize;
+	}
+	Check(isWritten && isRead, name + ": index file");
+
+	fptr = fopen(s_gzipNames[0], "rb");
+	bool isSameBlocks = nullptr != fptr;
+	// the blocks in reverse so each read seeks
+	for (size_t i = index.size(); i > 0 && isSameBlocks; --i)
+	{
+		std::string blockText;
+		isSameBlocks = GzipSink::ReadBlock(fptr, index[i - 1], blockText) && blockText == text.substr(index[i - 1].m_offset, index[i - 1].m_size);
+	}
+	std::vector<GzipSink::Block> notIndex;
+	bool isNotIndex = nullptr != fptr && !GzipSink::ReadIndex(fptr, notIndex);
+	if (nullptr != fptr)
+	{
+		fclose(fptr);
+	}
+	Check(isSameBlocks, name + ": blocks");
+	Check(isNotIndex, name + ": a file that is not an index");
+
+	for (const char *fileName : s_gzipNames)
+	{
+		remove(fileName);
+	}
+}
+
+// the value of the blind policy is at most the value of the solver, which is at most qmdp (on the start and on the belief of
+// each state), the vectors are the same with threads and read back from the .alpha text, and a model with a discount that is
+// not valid has no vectors
+static void TestSolver(const TestScenario& scenario)
+{
+	std::string name = scenario.m_name + ": solver";
+	std::unique_ptr<POMDP_Writer> writer = CreateWriter(scenario);
+	PomdpModel<double> model = writer->BuildModel<double>(scenario.m_idxTarget);
+	typedef PerseusSolver<double> solver_t;
+	solver_t solver(model, 1);
+	solver.SetBeliefs(100, 20);
+	solver.SetBudget(5, 0.0);
+	solver_t::Result result = solver.Solve();
+	const solver_t::AlphaVectors& alpha = solver.GetAlphaVectors();
+	solver_t::AlphaVectors blind = solver.CalcBlindPolicy();
+	solver_t::AlphaVectors qmdp = solver.CalcQmdp();
+
+	// the bounds are calculated to the epsilon of the budget
+	const double epsilon = 1e-3;
+	double value = solver.Value(alpha, solver.GetStart());
+	Check(result.m_numVectors == alpha.GetNumVectors() && result.m_numVectors > 0 && std::abs(result.m_lowerBound - value) <= s_tolerance, name + ": result");
+	Check(solver.Value(blind, solver.GetStart()) <= value + epsilon && value <= result.m_upperBound + epsilon
+		&& std::abs(result.m_upperBound - solver.Value(qmdp, solver.GetStart())) <= epsilon, name + ": bounds of the start");
+	bool isBounded = true;
+	for (size_t s = 0; s < model.GetNumStates() && isBounded; ++s)
+	{
+		solver_t::Belief state;
+		state.m_states.push_back(static_cast<uint32_t>(s));
+		state.m_p.push_back(1.0);
+		isBounded = solver.Value(alpha, state) <= solver.Value(qmdp, state) + epsilon;
+	}
+	Check(isBounded, name + ": bounds of the states");
+
+	solver_t threads(model, 4);
+	threads.SetBeliefs(100, 20);
+	threads.SetBudget(5, 0.0);
+	threads.Solve();
+	Check(threads.GetAlphaVectors().m_actions == alpha.m_actions && threads.GetAlphaVectors().m_values == alpha.m_values, name + " with 4 threads");
+
+	// the action of each vector in a line, its values in the next line and an empty line
+	MemorySink sink;
+	std::istringstream text(alpha.WriteAlpha(sink) ? sink.GetData() : std::string());
+	bool isSameText = true;
+	size_t numVectors = 0;
+	for (std::string actionLine, valuesLine, emptyLine; std::getline(text, actionLine) && isSameText; ++numVectors)
+	{
+		isSameText = numVectors < alpha.GetNumVectors() && std::getline(text, valuesLine) && std::getline(text, emptyLine) && emptyLine.empty()
+			&& std::to_string(alpha.m_actions[numVectors]) == actionLine;
+		std::istringstream values(valuesLine);
+		std::vector<double> read{ std::istream_iterator<double>(values), std::istream_iterator<double>() };
+		isSameText = isSameText && std::equal(read.begin(), read.end(), alpha.GetVector(numVectors), alpha.GetVector(numVectors) + alpha.m_numStates)
+			&& read.size() == alpha.m_numStates;
+	}
+	Check(isSameText && numVectors == alpha.GetNumVectors(), name + ": alpha text");
+
+	PomdpModel<double> undiscounted = writer->BuildModel<double>(scenario.m_idxTarget);
+	undiscounted.m_discount = 1.0;
+	solver_t invalid(undiscounted, 1);
+	solver_t::Result invalidResult = invalid.Solve();
+	Check(0 == invalidResult.m_numVectors && 0 == invalid.GetAlphaVectors().GetNumVectors() && 0 == invalidResult.m_iterations,
+		name + " with discount 1");
+}
+
+// the writer of the cache tests with an input of each section: the start of the non-involved (header), the movement of the
+// enemy (moves and shots) and the observation probability (observations)
+static std::unique_ptr<POMDP_Writer> CreateCacheWriter(double nonInvolvedStd, double enemyStay, double pObs)
+{
+	Point locSelf(0, 0, 0.4);
+	Move_Properties mSelf(0.2);
+	Self_Obj self(locSelf, mSelf, 1, 0.6, 2, pObs);
+	Point locEnemy(2, 2, 0.9);
+	Move_Properties mEnemy(enemyStay);
+	Attack_Obj enemy(locEnemy, mEnemy, 1, 0.5);
+	std::unique_ptr<POMDP_Writer> writer(new POMDP_Writer(3, self, enemy));
+
+	Point locNonInvolved(1, 0, nonInvolvedStd);
+	Move_Properties mNonInvolved(0.5);
+	Movable_Obj nonInvolved(locNonInvolved, mNonInvolved);
+	writer->AddObj(nonInvolved);
+	return writer;
+}
+
+// the text of the writer with the cache is the text without the cache, and the sections that are copied from the cache
+// are exactly cached (the names and the start are the header, the sections of the stats follow the sections of the text)
+static void CheckCachedSave(POMDP_Writer& writer, SectionCache& cache, size_t idxTarget, const std::vector<bool>& cached, const std::string& name)
+{
+	writer.SetSectionCache(nullptr);
+	std::string expected = SaveText(writer, idxTarget, 1);
+	writer.SetSectionCache(&cache);
+	MemorySink sink;
+	GenerationStats stats = writer.SaveInFormat(sink, idxTarget, 1);
+	writer.SetSectionCache(nullptr);
+
+	bool isSameCached = true;
+	for (int s = GenerationStats::SECTION_START; s < GenerationStats::NUM_SECTIONS; ++s)
+	{
+		isSameCached &= stats.m_sections[s].m_isCached == cached[s - GenerationStats::SECTION_START];
+	}
+	Check(isSameCached, name + ": cached sections");
+	Check(!stats.IsFailed() && !expected.empty() && sink.GetData() == expected, name + ": text from the cache");
+}
+
+// the sections are calculated on the first save and copied from the cache on the next saves. a change of an input calculates
+// again only the sections that depend on it (the key of a section is the hash of its inputs), and the other sections stay cached
+static void TestSectionCache()
+{
+	ContentHash first, same, swapped;
+	first.Add(uint64_t(1));
+	first.Add(0.5);
+	same.Add(uint64_t(1));
+	same.Add(0.5);
+	swapped.Add(0.5);
+	swapped.Add(uint64_t(1));
+	Check(first.GetKey() == same.GetKey() && first.GetKey() != swapped.GetKey(), "hash of the inputs");
+
+	std::filesystem::remove_all(s_cacheName);
+	std::filesystem::create_directory(s_cacheName);
+	SectionCache cache(s_cacheName);
+	std::unique_ptr<POMDP_Writer> writer = CreateCacheWriter(0.3, 0.3, 0.75);
+
+	// start, moves, shots and observations
+	CheckCachedSave(*writer, cache, 8, { false, false, false, false }, "cache miss");
+	size_t numEntries = std::distance(std::filesystem::directory_iterator(s_cacheName), std::filesystem::directory_iterator());
+	Check(4 == numEntries, "entry of each section (" + std::to_string(numEntries) + " entries)");
+	CheckCachedSave(*writer, cache, 8, { true, true, true, true }, "cache hit");
+
+	CheckCachedSave(*CreateCacheWriter(0.3, 0.3, 0.6), cache, 8, { true, true, true, false }, "observation changed");
+	CheckCachedSave(*CreateCacheWriter(0.3, 0.7, 0.75), cache, 8, { true, false, false, true }, "movement of the enemy changed");
+	CheckCachedSave(*CreateCacheWriter(0.6, 0.3, 0.75), cache, 8, { false, true, true, true }, "start changed");
+	CheckCachedSave(*writer, cache, 6, { false, false, false, true }, "target changed");
+	writer->SetIndexedOutput(true);
+	CheckCachedSave(*writer, cache, 8, { false, false, false, false }, "output with idx");
+	writer->SetIndexedOutput(false);
+	CheckCachedSave(*writer, cache, 8, { true, true, true, true }, "cache hit after changes");
+
+	std::filesystem::remove_all(s_cacheName);
+}
+
+// scenarios of the batch with objects that are not valid states return 0 without a file, and the valid scenario is written
+// as the text of its writer
+static void TestBatchValidation()
+{
+	Point locSelf(0, 0, 0.4);
+	Move_Properties mSelf(0.2);
+	Self_Obj self(locSelf, mSelf, 1, 0.6, 2, 0.75);
+	Point locEnemy(2, 2, 0.9);
+	Move_Properties mEnemy(0.3);
+	Attack_Obj enemy(locEnemy, mEnemy, 1, 0.5);
+	Point locNonInvolved(1, 0, 0.3);
+	Move_Properties mNonInvolved(0.5);
+	Movable_Obj nonInvolved(locNonInvolved, mNonInvolved);
+
+	std::vector<BatchScenario> scenarios;
+	scenarios.emplace_back(3, self, enemy, 8, s_batchNames[0]);
+	scenarios.back().m_nonInvolved.push_back(nonInvolved);
+	// more objects than cells and a grid of a single cell
+	scenarios.emplace_back(2, self, enemy, 3, s_batchNames[1]);
+	scenarios.back().m_nonInvolved.assign(3, nonInvolved);
+	scenarios.emplace_back(1, self, enemy, 0, s_batchNames[2]);
+	for (const char *name : s_batchNames)
+	{
+		remove(name);
+	}
+
+	BatchGenerator generator(2);
+	std::vector<size_t> bytesWritten = generator.Generate(scenarios);
+	Check(3 == bytesWritten.size() && 0 == bytesWritten[1] && 0 == bytesWritten[2], "batch: scenarios that are not valid");
+	Check(!std::filesystem::exists(s_batchNames[1]) && !std::filesystem::exists(s_batchNames[2]), "batch: no file for scenarios that are not valid");
+
+	POMDP_Writer writer(3, self, enemy);
+	writer.AddObj(nonInvolved);
+	std::string expected = SaveText(writer, 8, 1);
+	std::ifstream file(s_batchNames[0], std::ios::binary);
+	std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	Check(3 == bytesWritten.size() && bytesWritten[0] == expected.size() && text == expected, "batch: valid scenario");
+	file.close();
+	remove(s_batchNames[0]);
+}
+
+// the transitions permuted by the symmetries are the transitions calculated for every robot location, and the text is
+// the same with and without the symmetries (only the transitions as matrices use them)
+static void TestSymmetry(const TestScenario& scenario)
+{
+	std::unique_ptr<POMDP_Writer> writer = CreateWriter(scenario);
+	PomdpModel<double> direct = writer->BuildModel<double>(scenario.m_idxTarget);
+	std::string text = SaveText(*writer, scenario.m_idxTarget, 1);
+	writer->SetSymmetryReduction(true);
+	PomdpModel<double> symmetric = writer->BuildModel<double>(scenario.m_idxTarget);
+
+	bool isSame = direct.GetNumActions() > 0 && direct.GetNumActions() == symmetric.GetNumActions();
+	for (size_t a = 0; a < direct.GetNumActions() && isSame; ++a)
+	{
+		for (size_t s = 0; s < direct.GetNumStates() && isSame; ++s)
+		{
+			isSame = IsSameRow(MatrixRow(direct.m_transitions[a], s), MatrixRow(symmetric.m_transitions[a], s));
+		}
+	}
+	Check(isSame, scenario.m_name + ": transitions with the symmetries");
+	Check(!text.empty() && text == SaveText(*writer, scenario.m_idxTarget, 1), scenario.m_name + ": text with the symmetries");
+}
+
+// the states of the pruned model are the states reached from the start by any action (and win and loss) in the order of
+// their idx, and their rows and start are the rows and the start of the model without pruning
+static void TestPruning(POMDP_Writer& writer, size_t idxTarget, const std::string& name)
+{
+	writer.SetReachablePruning(false);
+	PomdpModel<double> full = writer.BuildModel<double>(idxTarget);
+	writer.SetReachablePruning(true);
+	PomdpModel<double> pruned = writer.BuildModel<double>(idxTarget);
+
+	// breadth first search on the transitions of the model without pruning
+	size_t numStates = full.GetNumStates();
+	std::vector<bool> isReached(numStates, false);
+	std::vector<size_t> queue;
+	for (size_t s = 0; s < numStates; ++s)
+	{
+		if (full.m_start[s] > 0 || s + 2 >= numStates)
+		{
+			isReached[s] = true;
+			queue.push_back(s);
+		}
+	}
+	for (size_t next = 0; next < queue.size(); ++next)
+	{
+		for (const auto& matrix : full.m_transitions)
+		{
+			for (uint64_t k = matrix.m_rowOffsets[queue[next]]; k < matrix.m_rowOffsets[queue[next] + 1]; ++k)
+			{
+				if (matrix.m_values[k] > 0 && !isReached[matrix.m_columns[k]])
+				{
+					isReached[matrix.m_columns[k]] = true;
+					queue.push_back(matrix.m_columns[k]);
+				}
+			}
+		}
+	}
+	std::vector<uint64_t> reached;
+	for (size_t s = 0; s < numStates; ++s)
+	{
+		if (isReached[s])
+		{
+			reached.push_back(s);
+		}
+	}
+	Check(reached == pruned.m_stateIds && reached.size() == pruned.GetNumStates(), name + ": reachable states ("
+		+ std::to_string(reached.size()) + " of " + std::to_string(numStates) + ")");
+	if (reached != pruned.m_stateIds)
+	{
+		return;
+	}
+
+	bool isSame = pruned.GetNumActions() == full.GetNumActions();
+	for (size_t s = 0; s < pruned.GetNumStates() && isSame; ++s)
+	{
+		for (size_t a = 0; a < full.GetNumActions() && isSame; ++a)
+		{
+			row_t row;
+			for (const auto& entry : MatrixRow(pruned.m_transitions[a], s))
+			{
+				row[pruned.m_stateIds[entry.first]] = entry.second;
+			}
+			isSame = IsSameRow(MatrixRow(full.m_transitions[a], pruned.m_stateIds[s]), row);
+		}
+		isSame = isSame && pruned.m_start[s] == full.m_start[pruned.m_stateIds[s]] && pruned.m_rewards[s] == full.m_rewards[pruned.m_stateIds[s]];
+	}
+	Check(isSame, name + ": rows of the reachable states");
+}
+
+// the text with threads is the same bytes as the text of a single thread
+static void TestThreads(const TestScenario& scenario, bool isPruned)
+{
+	std::string name = scenario.m_name + (isPruned ? " pruned" : "");
+	std::unique_ptr<POMDP_Writer> writer = CreateWriter(scenario);
+	writer->SetReachablePruning(isPruned);
+	std::string single = SaveText(*writer, scenario.m_idxTarget, 1);
+	Check(!single.empty() && single == SaveText(*writer, scenario.m_idxTarget, 4), name + ": text with 4 threads");
+}
+
+// the belief of the filter after random actions and observations is the bayes update of the model in memory
+static void TestBeliefFilter(const TestScenario& scenario)
+{
+	std::unique_ptr<POMDP_Writer> writer = CreateWriter(scenario);
+	PomdpModel<double> model = writer->BuildModel<double>(scenario.m_idxTarget);
+	BeliefFilter filter = writer->CreateBeliefFilter(scenario.m_idxTarget);
+	size_t numStates = model.GetNumStates();
+	const CsrMatrixT<double>& observations = model.m_observations;
+
+	std::mt19937 random(7);
+	double maxError = 0.0;
+	size_t numUpdates = 0;
+	for (size_t episode = 0; episode < 20; ++episode)
+	{
+		std::vector<double> belief(model.m_start.begin(), model.m_start.end());
+		std::vector<BeliefFilter::Entry> start;
+		for (size_t s = 0; s < numStates; ++s)
+		{
+			if (belief[s] > 0)
+			{
+				start.push_back(BeliefFilter::Entry{ s, belief[s] });
+			}
+		}
+		filter.SetBelief(start);
+
+		// a trajectory of the model: a random action, an end-state and an observation of the end-state
+		size_t state = std::discrete_distribution<size_t>(belief.begin(), belief.end())(random);
+		for (size_t step = 0; step < 20; ++step)
+		{
+			size_t action = random() % model.GetNumActions();
+			const CsrMatrixT<double>& transitions = model.m_transitions[action];
+			std::vector<double> row(transitions.m_values.begin() + transitions.m_rowOffsets[state], transitions.m_values.begin() + transitions.m_rowOffsets[state + 1]);
+			if (row.empty())
+			{
+				break;
+			}
+			size_t endState = transitions.m_columns[transitions.m_rowOffsets[state] + std::discrete_distribution<size_t>(row.begin(), row.end())(random)];
+			row_t observationRow = MatrixRow(observations, endState);
+			if (observationRow.empty())
+			{
+				break;
+			}
+			std::vector<double> pObservations;
+			for (const auto& entry : observationRow)
+			{
+				pObservations.push_back(entry.second);
+			}
+			auto observation = observationRow.begin();
+			std::advance(observation, std::discrete_distribution<size_t>(pObservations.begin(), pObservations.end())(random));
+
+			// b'(s') = O(s', z) * sum of T(s, s') * b(s) / P(z)
+			std::vector<double> next(numStates, 0.0);
+			for (size_t s = 0; s < numStates; ++s)
+			{
+				for (uint64_t k = transitions.m_rowOffsets[s]; k < transitions.m_rowOffsets[s + 1] && belief[s] > 0; ++k)
+				{
+					next[transitions.m_columns[k]] += belief[s] * transitions.m_values[k];
+				}
+			}
+			double pObservation = 0.0;
+			for (size_t s = 0; s < numStates; ++s)
+			{
+				next[s] *= MatrixValue(observations, s, observation->first);
+				pObservation += next[s];
+			}
+			for (auto & p : next)
+			{
+				p /= pObservation;
+			}
+
+			// without pruning the states and the observations of the model are the idx of StateIndexer
+			maxError = std::max(maxError, std::abs(filter.Update(action, observation->first) - pObservation));
+			std::vector<double> filtered(numStates, 0.0);
+			for (const auto& entry : filter.GetBelief())
+			{
+				filtered[entry.m_idx] = entry.m_p;
+			}
+			for (size_t s = 0; s < numStates; ++s)
+			{
+				maxError = std::max(maxError, std::abs(filtered[s] - next[s]));
+			}
+
+			belief.swap(next);
+			state = endState;
+			++numUpdates;
+		}
+	}
+
+	Check(numUpdates > 0 && maxError <= s_tolerance, scenario.m_name + ": belief filter (max error " + std::to_string(maxError) + ")");
+}
+
+static std::vector<std::string> SplitWords(const std::string& line)
+{
+	std::istringstream in(line);
+	return std::vector<std::string>(std::istream_iterator<std::string>(in), std::istream_iterator<std::string>());
+}
+
+// the text from the start line (the header is different with names and with idx)
+static std::vector<std::string> LinesFromStart(const std::string& text)
+{
+	std::istringstream in(text.substr(std::min(text.find("\nstart:"), text.size())));
+	std::vector<std::string> lines;
+	for (std::string line; std::getline(in, line);)
+	{
+		lines.push_back(line);
+	}
+
+	return lines;
+}
+
+// the text with idx is the text with names where each name is replaced by its idx in the names (the header is different)
+static void TestIndexedOutput(const TestScenario& scenario)
+{
+	std::unique_ptr<POMDP_Writer> writer = CreateWriter(scenario);
+	MemorySink namesSink;
+	writer->SetIndexedOutput(true, &namesSink);
+	std::vector<std::string> indexed = LinesFromStart(SaveText(*writer, scenario.m_idxTarget, 1));
+	writer->SetIndexedOutput(false);
+	std::vector<std::string> named = LinesFromStart(SaveText(*writer, scenario.m_idxTarget, 1));
+
+	// lines "<idx> <name>" in the sections of the states, the actions and the observations (the names are different)
+	std::map<std::string, std::string> idxOfName;
+	std::istringstream names(namesSink.GetData());
+	for (std::string idx, name; names >> idx;)
+	{
+		if (idx.back() != ':' && names >> name)
+		{
+			idxOfName[name] = idx;
+		}
+	}
+
+	bool isSame = !named.empty() && named.size() == indexed.size();
+	for (size_t i = 0; i < named.size() && isSame; ++i)
+	{
+		std::vector<std::string> words = SplitWords(named[i]);
+		for (auto & word : words)
+		{
+			auto itr = idxOfName.find(word);
+			word = itr == idxOfName.end() ? word : itr->second;
+		}
+		isSame = words == SplitWords(indexed[i]);
+	}
+	Check(isSame, scenario.m_name + ": text with idx is the text with names");
+}
+
+// every state and end-state of the transitions is in the states line and every observation is in the observations line
+// (with a dead enemy in the last location of the name, and with moves to taken locations)
+static void TestDeclaredNames(POMDP_Writer& writer, size_t idxTarget, const std::string& name)
+{
+	writer.SetIndexedOutput(false);
+	std::istringstream text(SaveText(writer, idxTarget, 1));
+	std::set<std::string> states, observations;
+	size_t numRows = 0;
+	bool isDeclared = true;
+	for (std::string line; std::getline(text, line);)
+	{
+		std::vector<std::string> words = SplitWords(line);
+		if (!words.empty() && ("states:" == words[0] || "observations:" == words[0]))
+		{
+			("states:" == words[0] ? states : observations).insert(words.begin() + 1, words.end());
+		}
+		else if (words.size() == 7 && ("T:" == words[0] || "O:" == words[0]) && "*" != words[3])
+		{
+			const std::set<std::string>& ends = "T:" == words[0] ? states : observations;
+			isDeclared &= states.count(words[3]) > 0 && ends.count(words[5]) > 0;
+			++numRows;
+		}
+	}
+	Check(numRows > 0 && isDeclared, name + ": declared names");
+}
+
+// a move to a taken location returns the moved object to its previous location, and the robot stays when it moves
+// to an object that stays. the corrections are repeated until no two objects are in the same location
+static void TestMoveCorrections()
+{
+	// the robot moves from 0 to the object that stays in 1
+	int blocked[] = { 1, 1, 5 };
+	int blockedOrigins[] = { 1, 5 };
+	POMDP_Writer::NoRepetitionCheckAndCorrect(blocked, 3, blockedOrigins, 0);
+	Check(0 == blocked[0] && 1 == blocked[1] && 5 == blocked[2], "robot blocked by an object that stays");
+
+	// the robot moves to 2 and the object moves from 2 to 3 (no correction)
+	int free[] = { 2, 3, 5 };
+	int freeOrigins[] = { 2, 5 };
+	POMDP_Writer::NoRepetitionCheckAndCorrect(free, 3, freeOrigins, 1);
+	Check(2 == free[0] && 3 == free[1] && 5 == free[2], "robot moves to the location an object left");
+
+	// the object from 4 moves to 5 where the object that stays is, and its return to 4 collides with the object
+	// that moved from 6 to 4 (found only in a second pass on the objects)
+	int chained[] = { 0, 4, 5, 5 };
+	int chainedOrigins[] = { 6, 4, 5 };
+	POMDP_Writer::NoRepetitionCheckAndCorrect(chained, 4, chainedOrigins, 0);
+	Check(0 == chained[0] && 6 == chained[1] && 4 == chained[2] && 5 == chained[3], "chained collisions of objects");
+}
+
+// the objects with std 0 are in their cell in every start state where the cell is not taken by a previous object
+// (also in the start of the pruned model and of the filter)
+static void TestStartNoStd(bool isPruned)
+{
+	std::string name = std::string("start with std 0") + (isPruned ? " pruned" : "");
+	Point locSelf(2, 1);
+	Move_Properties mSelf(0.2);
+	Self_Obj self(locSelf, mSelf, 1, 0.6, 2, 0.75);
+	Point locEnemy(0, 0, 0.9);
+	Move_Properties mEnemy(0.3);
+	Attack_Obj enemy(locEnemy, mEnemy, 1, 0.5);
+	POMDP_Writer writer(3, self, enemy);
+	Point locNonInvolved(1, 2);
+	Move_Properties mNonInvolved(0.5);
+	Movable_Obj nonInvolved(locNonInvolved, mNonInvolved);
+	writer.AddObj(nonInvolved);
+	writer.SetReachablePruning(isPruned);
+
+	PomdpModel<double> model = writer.BuildModel<double>(8);
+	StateIndexer indexer(3, 3);
+	std::vector<int> stateVec(3);
+	double sum = 0.0;
+	bool isInCell = true;
+	std::set<int> enemyCells;
+	for (size_t s = 0; s < model.GetNumStates(); ++s)
+	{
+		if (model.m_start[s] > 0)
+		{
+			indexer.Unrank(isPruned ? model.m_stateIds[s] : s, &stateVec[0]);
+			isInCell &= 5 == stateVec[0] && (7 == stateVec[2] || 7 == stateVec[ENEMY_IDX]);
+			enemyCells.insert(stateVec[ENEMY_IDX]);
+			sum += model.m_start[s];
+		}
+	}
+	Check(isInCell && enemyCells.size() == 8 && std::abs(sum - 1.0) <= s_tolerance, name + ": cells of the objects");
+
+	BeliefFilter filter = writer.CreateBeliefFilter(8);
+	bool isFilterInCell = !filter.GetBelief().empty();
+	for (const auto& entry : filter.GetBelief())
+	{
+		indexer.Unrank(entry.m_idx, &stateVec[0]);
+		isFilterInCell &= 5 == stateVec[0] && (7 == stateVec[2] || 7 == stateVec[ENEMY_IDX]);
+	}
+	Check(isFilterInCell, name + ": cells of the objects in the filter");
+}
+
+// every idx of the live and dead states is unranked to a state without repetitions and ranked back to the same idx,
+// in the order of the states line (lexicographic by the locations, live before dead)
+static void TestIndexer(size_t gridSize, size_t numObjects)
+{
+	std::string name = "indexer of " + std::to_string(numObjects) + " objects in grid " + std::to_string(gridSize);
+	StateIndexer indexer(gridSize, numObjects);
+	Check(indexer.IsValid(), name + ": valid");
+
+	// live states are the permutations of numObjects cells and dead states of numObjects - 1 cells
+	size_t numCells = gridSize * gridSize;
+	size_t numLive = 1, numDead = 1;
+	for (size_t i = 0; i < numObjects; ++i)
+	{
+		numLive *= numCells - i;
+		numDead *= i + 1 < numObjects ? numCells - i : 1;
+	}
+	Check(indexer.NumLive() == numLive && indexer.NumDead() == numDead && indexer.NumStates() == numLive + numDead + 2, name + ": numbers of states");
+
+	bool isRoundTrip = true, isLegal = true, isOrdered = true;
+	std::vector<int> stateVec(numObjects), prev;
+	for (size_t idx = 0; idx < indexer.WinIdx(); ++idx)
+	{
+		indexer.Unrank(idx, &stateVec[0]);
+		isRoundTrip &= indexer.Rank(&stateVec[0]) == idx;
+		isLegal &= indexer.GetSelf(idx) == stateVec[0] && indexer.IsDead(idx) == (DEAD_ENEMY == stateVec[ENEMY_IDX]);
+		for (size_t i = 0; i < numObjects; ++i)
+		{
+			isLegal &= DEAD_ENEMY == stateVec[i] ? ENEMY_IDX == i : stateVec[i] >= 0 && static_cast<size_t>(stateVec[i]) < numCells;
+			for (size_t j = 0; j < i; ++j)
+			{
+				isLegal &= stateVec[i] != stateVec[j];
+			}
+		}
+		// the first dead state starts a new order
+		isOrdered &= prev.empty() || idx == indexer.NumLive() || std::lexicographical_compare(prev.begin(), prev.end(), stateVec.begin(), stateVec.end());
+		prev = stateVec;
+	}
+	Check(isRoundTrip, name + ": rank of unrank");
+	Check(isLegal, name + ": legal states");
+	Check(isOrdered, name + ": order of the states");
+}
+
+// objects that are not valid states don't stop the process: the indexer has no states and the writer reports the error
+static void TestInvalidObjects()
+{
+	Check(!StateIndexer::IsValid(1, 2) && !StateIndexer::IsValid(3, 1) && !StateIndexer::IsValid(3, StateIndexer::s_maxObjects + 1)
+		&& !StateIndexer::IsValid(2, 5) && !StateIndexer::IsValid(size_t(1) << 16, StateIndexer::s_maxObjects), "invalid objects");
+	Check(StateIndexer::IsValid(2, 4) && StateIndexer::IsValid(5, 6), "valid objects");
+
+	StateIndexer indexer(1, 2);
+	Check(!indexer.IsValid() && 2 == indexer.NumStates() && 0 == indexer.NumLive() + indexer.NumDead(), "indexer of invalid objects");
+
+	Point locSelf(0, 0);
+	Move_Properties mSelf(0.2);
+	Self_Obj self(locSelf, mSelf, 1, 0.6, 2, 0.75);
+	Point locEnemy(0, 0);
+	Move_Properties mEnemy(0.3);
+	Attack_Obj enemy(locEnemy, mEnemy, 1, 0.5);
+	POMDP_Writer writer(1, self, enemy);
+
+	MemorySink sink;
+	GenerationStats stats = writer.SaveInFormat(sink, 0);
+	Check(stats.IsFailed() && sink.GetData().empty(), "text of invalid objects");
+	MemorySink binary;
+	Check(0 == writer.SaveBinary(binary, 0) && binary.GetData().empty(), "binary of invalid objects");
+	Check(0 == writer.BuildModel<double>(0).GetNumStates(), "model of invalid objects");
+	Check(writer.CreateBeliefFilter(0).GetBelief().empty(), "belief filter of invalid objects");
+}
+
+int main()
+{
+	TestIndexer(3, 2);
+	TestIndexer(3, 4);
+	TestIndexer(2, 4);
+	TestInvalidObjects();
+	TestMoveCorrections();
+	TestStartNoStd(false);
+	TestStartNoStd(true);
+	TestSectionCache();
+	TestBatchValidation();
+
+	// robot and enemy only: the dead enemy is the last location of the name
+	Point locSelf(0, 0, 0.4);
+	Move_Properties mSelf(0.2);
+	Self_Obj self(locSelf, mSelf, 1, 0.6, 2, 0.75);
+	Point locEnemy(1, 0, 0.9);
+	Move_Properties mEnemy(0.3);
+	Attack_Obj enemy(locEnemy, mEnemy, 1, 0.5);
+	POMDP_Writer twoObjects(3, self, enemy);
+	TestDeclaredNames(twoObjects, 8, "robot and enemy");
+	// a target outside the grid is kept by all the symmetries
+	TestSymmetry(TestScenario{ "outside target", 9, false });
+
+	// a non-involved that never moves from its cell (all the objects start in a single cell): most of the states are not reachable
+	Point locSelfNoStd(0, 0);
+	Self_Obj selfNoStd(locSelfNoStd, mSelf, 1, 0.6, 2, 0.75);
+	Point locEnemyNoStd(2, 2);
+	Attack_Obj enemyNoStd(locEnemyNoStd, mEnemy, 1, 0.5);
+	Point locStays(1, 0);
+	Move_Properties mStays(1.0);
+	Movable_Obj stays(locStays, mStays);
+	POMDP_Writer withStays(3, selfNoStd, enemyNoStd);
+	withStays.AddObj(stays);
+	TestPruning(withStays, 8, "non-involved that stays");
+
+	std::vector<TestScenario> scenarios = { { "center target", 4, false }, { "corner target", 8, true } };
+	for (const auto& scenario : scenarios)
+	{
+		for (int settings = 0; settings < 4; ++settings)
+		{
+			TestSameModel(scenario, 0 != (settings & 1), 0 != (settings & 2));
+		}
+		TestThreads(scenario, false);
+		TestThreads(scenario, true);
+		TestBeliefFilter(scenario);
+		TestIndexedOutput(scenario);
+		TestSymmetry(scenario);
+		TestPruning(*CreateWriter(scenario), scenario.m_idxTarget, scenario.m_name);
+		TestStats(scenario);
+		TestEstimate(scenario);
+		TestGzip(scenario);
+		TestSolver(scenario);
+		TestDeclaredNames(*CreateWriter(scenario), scenario.m_idxTarget, scenario.m_name);
+	}
+
+	std::cout << (0 == s_failed ? "all tests passed\n" : std::to_string(s_failed) + " tests failed\n");
+	return s_failed;
+}
@@ -0,0 +1,71 @@
+#include "OutputSink.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <cerrno>
+
+bool OutputSink::Write(const char * data, size_t size)
+{
+	if (!WriteIMP(data, size))
+	{
+		return false;
+	}
+
+	m_bytesWritten += size;
+	return true;
+}
+
+bool FileSink::WriteIMP(const char * data, size_t size)
+{
+	return fwrite(data, 1, size, m_fptr) == size;
+}
+
+FILE *FileSink::Open(const char *fileName, const char *mode)
+{
+#ifdef _WIN32
+	FILE *fptr = nullptr;
+	return 0 == fopen_s(&fptr, fileName, mode) ? fptr : nullptr;
+#else
+	return fopen(fileName, mode);
+#endif
+}
+
+bool FileSink::Flush()
+{
+	return fflush(m_fptr) == 0;
+}
+
+bool FdSink::WriteIMP(const char * data, size_t size)
+{
+	// write can return before writing all the data, continue until all data is written
+	while (size > 0)
+	{
+#ifdef _WIN32
+		int written = _write(m_fd, data, static_cast<unsigned int>(size));
+#else
+		ssize_t written = write(m_fd, data, size);
+#endif
+		if (written < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+
+	return true;
+}
+
+bool MemorySink::WriteIMP(const char * data, size_t size)
+{
+	m_data.append(data, size);
+	return true;
+}
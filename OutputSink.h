@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdio>
+#include <cstddef>
+#include <string>
+
+//	destination of the pomdp format text.
+//	the writer streams the format to the sink in chunks (see ChunkBuffer) so the sink never
+//	needs to hold a whole section in memory (except MemorySink that collects the text).
+class OutputSink
+{
+public:
+	OutputSink() : m_bytesWritten(0) {}
+	virtual ~OutputSink() = default;
+
+	// write size bytes from data. returns false on failure
+	bool Write(const char *data, size_t size);
+	virtual bool Flush() { return true; }
+
+	size_t GetBytesWritten() const { return m_bytesWritten; }
+
+protected:
+	virtual bool WriteIMP(const char *data, size_t size) = 0;
+
+private:
+	size_t m_bytesWritten;
+};
+
+// sink to an open FILE (the file is not closed by the sink)
+class FileSink : public OutputSink
+{
+public:
+	explicit FileSink(FILE *fptr) : m_fptr(fptr) {}
+
+	// open a file with the mode of fopen. returns nullptr on failure
+	static FILE *Open(const char *fileName, const char *mode);
+
+	bool Flush() override;
+
+protected:
+	bool WriteIMP(const char *data, size_t size) override;
+
+private:
+	FILE *m_fptr;
+};
+
+// sink to an open file descriptor (the descriptor is not closed by the sink)
+class FdSink : public OutputSink
+{
+public:
+	explicit FdSink(int fd) : m_fd(fd) {}
+
+protected:
+	bool WriteIMP(const char *data, size_t size) override;
+
+private:
+	int m_fd;
+};
+
+// sink that collects the text in memory
+class MemorySink : public OutputSink
+{
+public:
+	MemorySink() : m_data() {}
+
+	const std::string& GetData() const { return m_data; }
+	void Clear() { m_data.clear(); }
+
+protected:
+	bool WriteIMP(const char *data, size_t size) override;
+
+private:
+	std::string m_data;
+};
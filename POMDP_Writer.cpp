@@ -4,58 +4,92 @@
 #include <random>
 #include <math.h>
 #include <memory.h>
-#include <sstream>
-#include <iomanip>
+#include <cstring>
 #include <algorithm>
+#include <deque>
+#include <chrono>
+#include <type_traits>
+
+#include "BinaryModelWriter.h"
+#include "TextFormat.h"
+#include "StartDistribution.h"
+#include "SectionCache.h"
 
 static const std::string s_WinState = "Win";
 static const std::string s_LossState = "Loss";
 
-// value in move states for non-valid move
-static const int NVALID_MOVE = -1;
-// value in stateVec for dead enemy
-static const int DEAD_ENEMY = -2;
-// idx of enemy in the stateVec
-static const int ENEMY_IDX = 1;
+// names of the actions in the order of their idx
+static const std::string s_actions[] = { "Stay", "North", "South", "East", "West", "Shoot_North", "Shoot_South", "Shoot_West", "Shoot_East" };
+static const size_t s_numActions = sizeof(s_actions) / sizeof(s_actions[0]);
+// action for all the actions ("*")
+static const int ALL_ACTIONS = SparseModelBuilder::s_allActions;
 
-// idx for win state
-static size_t s_idxTarget;
-// to convey probability between calculations
-static double s_pLeftProbability = 1.0;
+// default digits after the point of probabilities and significant digits of start probabilities
+static const int s_defaultPrecision = 6;
+static const int s_startPrecision = 10;
 
-POMDP_Writer::state_t POMDP_Writer::s_junkState{ NVALID_MOVE };
+// reward for acting in win and loss states
+static const double s_winReward = 100;
+static const double s_lossReward = -100;
 
-inline int Abs(int x)
+// version of the text of the sections in the section cache (raised on every change of the text)
+static const uint64_t s_textVersion = 2;
+
+// direction of the move or of the shot of each action
+static const GridDirection s_actionDirections[] = { DIR_STAY, DIR_NORTH, DIR_SOUTH, DIR_EAST, DIR_WEST, DIR_NORTH, DIR_SOUTH, DIR_WEST, DIR_EAST };
+
+// value in move states for non-valid move
+static const int NVALID_MOVE = -1;
+
+// idx of action name
+static int ActionIdx(const std::string& action)
 {
-	return x * (x >= 0) - x * (x < 0);
+	return static_cast<int>(std::find(s_actions, s_actions + s_numActions, action) - s_actions);
 }
 
-// translate to string with higher precision
-inline std::string to_string_precision(double d, int n = 10)
+inline int Abs(int x)
 {
-	std::ostringstream out;
-	out << std::setprecision(n) << d;
-	return out.str();
+	return x * (x >= 0) - x * (x < 0);
 }
 
-static double Sum(const double *arr, size_t size)
+// seconds from start until now
+static double SecondsSince(std::chrono::steady_clock::time_point start)
 {
-	double p = 0;
-	for (size_t i = 0; i < size; ++i)
-	{
-		p += arr[i];
-	}
-
-	return p;
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
 }
 
 POMDP_Writer::POMDP_Writer(size_t gridSize, Self_Obj& self, Attack_Obj& enemy, double discount)
 : m_gridSize(gridSize)
+, m_topology(std::make_shared<GridTopology>(gridSize))
 , m_self(self)
 , m_enemy(enemy)
 , m_NInvVector()
 , m_shelter()
 , m_discount(discount)
+, m_indexer(gridSize, 2)
+, m_idxTarget(0)
+, m_pool()
+, m_isIndexed(false)
+, m_namesSink(nullptr)
+, m_winName(s_WinState)
+, m_lossName(s_LossState)
+, m_precision(s_defaultPrecision)
+, m_startEpsilon(0.0)
+, m_isSparseStart(false)
+, m_isSymmetric(false)
+, m_isPruned(false)
+, m_reachable()
+, m_observationIdx()
+, m_numObservations(0)
+, m_sectionCache(nullptr)
+, m_gridTables(nullptr)
+, m_stats()
+, m_counters()
+, m_sectionStart()
+, m_sectionBytes(0)
+, m_reportSink(nullptr)
+, m_actionNames()
+, m_model(nullptr)
 {
 }
 
@@ -69,29 +103,700 @@ void POMDP_Writer::AddObj(ObjInGrid& obj)
 	m_shelter.emplace_back(obj);
 }
 
-void POMDP_Writer::SaveInFormat(FILE *fptr, size_t idxTarget)
+void POMDP_Writer::SetIndexedOutput(bool isIndexed, OutputSink *namesSink)
+{
+	m_isIndexed = isIndexed;
+	m_namesSink = namesSink;
+}
+
+void POMDP_Writer::SetPrecision(int precision)
+{
+	m_precision = precision;
+}
+
+void POMDP_Writer::SetStartEpsilon(double epsilon)
+{
+	m_startEpsilon = epsilon;
+}
+
+void POMDP_Writer::SetSparseStart(bool isSparse)
+{
+	m_isSparseStart = isSparse;
+}
+
+void POMDP_Writer::SetSymmetryReduction(bool isSymmetric)
+{
+	m_isSymmetric = isSymmetric;
+}
+
+void POMDP_Writer::SetReachablePruning(bool isPruned)
+{
+	m_isPruned = isPruned;
+}
+
+void POMDP_Writer::SetSectionCache(SectionCache *cache)
+{
+	m_sectionCache = cache;
+}
+
+void POMDP_Writer::SetGridTables(GridTables *tables)
+{
+	m_gridTables = tables;
+}
+
+void POMDP_Writer::SetStatsReport(OutputSink *reportSink)
+{
+	m_reportSink = reportSink;
+}
+
+ModelEstimate POMDP_Writer::EstimateModel(size_t idxTarget, size_t threads) const
+{
+	ModelEstimate::Scenario scenario;
+	scenario.m_gridSize = m_gridSize;
+	scenario.m_numNonInvolved = m_NInvVector.size();
+	scenario.m_enemyRange = m_enemy.GetRange();
+	scenario.m_selfRange = m_self.GetRange();
+	scenario.m_isTargetInGrid = idxTarget < m_gridSize * m_gridSize;
+	scenario.m_isIndexed = m_isIndexed;
+	scenario.m_precision = m_precision;
+	scenario.m_isPruned = m_isPruned;
+	scenario.m_threads = threads;
+	return ModelEstimate::Calc(scenario);
+}
+
+GenerationStats POMDP_Writer::SaveInFormat(FILE *fptr, size_t idxTarget, size_t threads)
+{
+	FileSink sink(fptr);
+	return SaveInFormat(sink, idxTarget, threads);
+}
+
+GenerationStats POMDP_Writer::SaveInFormat(OutputSink& sink, size_t idxTarget, size_t threads)
+{
+		auto start = std::chrono::steady_clock::now();
+		ChunkBuffer buffer(sink);
+		size_t bytesBefore = sink.GetBytesWritten();
+		// nothing is written when the objects are not valid states (the error is in the stats)
+		if (InitSave(idxTarget, threads))
+		{
+			if (m_isPruned)
+			{
+				std::vector<CsrMatrix> transitions;
+				CalcTransitionMatrices(transitions);
+				CalcReachable(transitions);
+			}
+			m_winName = m_isIndexed ? std::to_string(OutputIdx(m_indexer.WinIdx(), "s")) : s_WinState;
+			m_lossName = m_isIndexed ? std::to_string(OutputIdx(m_indexer.LossIdx(), "s")) : s_LossState;
+
+			if (nullptr != m_namesSink && !WriteNames(*m_namesSink))
+			{
+				m_stats.m_error = "Error Writing names";
+			}
+
+			//add comments and init lines(state observations etc.) to file
+			WriteSection(buffer, TEXT_HEADER, &POMDP_Writer::CommentsAndInitLines);
+
+			// add position with and without moving of the robot
+			WriteSection(buffer, TEXT_POSITIONS, &POMDP_Writer::PositionStates);
+
+			// add hits calculation
+			WriteSection(buffer, TEXT_HITS, &POMDP_Writer::AttackAction);
+
+			// add observations and rewards
+			WriteSection(buffer, TEXT_OBSERVATIONS, &POMDP_Writer::ObservationsAndRewards);
+		}
+
+		m_pool.reset();
+		m_reachable.reset();
+		buffer.Flush();
+		if (!m_stats.IsFailed() && (buffer.IsFailed() || !sink.Flush()))
+		{
+			m_stats.m_error = "Error Writing to file";
+		}
+		// sections from the cache are written directly to the sink
+		m_stats.m_bytesWritten = sink.GetBytesWritten() - bytesBefore;
+		m_stats.m_seconds = SecondsSince(start);
+		m_stats.m_threads = threads > 1 ? threads : 1;
+		if (nullptr != m_reportSink)
+		{
+			std::string report = m_stats.ToJson();
+			if ((!m_reportSink->Write(report.data(), report.size()) || !m_reportSink->Flush()) && !m_stats.IsFailed())
+			{
+				m_stats.m_error = "Error Writing report";
+			}
+		}
+		return m_stats;
+}
+
+size_t POMDP_Writer::SaveBinary(FILE *fptr, size_t idxTarget, size_t threads)
+{
+	FileSink sink(fptr);
+	return SaveBinary(sink, idxTarget, threads);
+}
+
+size_t POMDP_Writer::SaveBinary(OutputSink& sink, size_t idxTarget, size_t threads)
+{
+	if (!InitSave(idxTarget, threads))
+	{
+		return 0;
+	}
+	size_t numStates = m_indexer.NumStates();
+	size_t numObservations = m_indexer.NumLive() + m_indexer.NumDead();
+
+	std::vector<CsrMatrix> transitions;
+	CalcTransitionMatrices(transitions);
+	m_pool.reset();
+
+	// observations are written as factors of each object instead of the observations of all the objects together
+	size_t numFactors = m_indexer.GetNumObjects() - 1;
+	std::vector<BinaryObservationFactor> observations(numStates * numFactors, BinaryObservationFactor{ 0, OBS_NONE, 0.0 });
+	for (size_t idx = 0; idx < numObservations; ++idx)
+	{
+		CalcObsFactors(idx, &observations[idx * numFactors]);
+	}
+
+	// rewards and start (only live states are possible at start)
+	std::vector<double> rewards(numStates, 0.0);
+	rewards[m_indexer.WinIdx()] = s_winReward;
+	rewards[m_indexer.LossIdx()] = s_lossReward;
+
+	std::vector<double> start(numStates, 0.0);
+	for (const auto& entry : CalcStart())
+	{
+		start[entry.m_idx] = entry.m_p;
+	}
+
+	// keep the rows of the reachable states (the idx of each state in the indexer is written to the state ids)
+	if (m_isPruned)
+	{
+		CalcReachable(transitions);
+		for (auto & matrix : transitions)
+		{
+			matrix = m_reachable->Prune(matrix);
+		}
+		observations = m_reachable->Prune(observations, numFactors);
+		rewards = m_reachable->Prune(rewards);
+		start = m_reachable->Prune(start);
+		numStates = m_reachable->GetNumReachable();
+	}
+
+	BinaryModelWriter writer(m_gridSize, m_indexer.GetNumObjects(), s_numActions, numStates, numObservations, m_discount);
+	for (size_t a = 0; a < s_numActions; ++a)
+	{
+		writer.AddMatrix(SECTION_T_ROW_OFFSETS, a, transitions[a]);
+	}
+	writer.AddSection(SECTION_O_FACTORS, 0, observations.data(), observations.size() * sizeof(BinaryObservationFactor));
+	writer.AddSection(SECTION_REWARDS, 0, rewards.data(), rewards.size() * sizeof(double));
+	writer.AddSection(SECTION_START, 0, start.data(), start.size() * sizeof(double));
+	if (m_isPruned)
+	{
+		writer.AddSection(SECTION_STATE_IDS, 0, m_reachable->GetStates().data(), numStates * sizeof(uint64_t));
+	}
+
+	size_t bytesWritten = writer.Write(sink);
+	m_reachable.reset();
+	return sink.Flush() ? bytesWritten : 0;
+}
+
+// matrix with values of type T (the matrix of double is moved or released while converting so only one copy is kept)
+template <typename T>
+static CsrMatrixT<T> ConvertMatrix(CsrMatrix& matrix)
+{
+	CsrMatrixT<T> converted;
+	converted.m_numCols = matrix.m_numCols;
+	converted.m_rowOffsets.swap(matrix.m_rowOffsets);
+	converted.m_columns.swap(matrix.m_columns);
+	if constexpr (std::is_same<T, double>::value)
+	{
+		converted.m_values.swap(matrix.m_values);
+	}
+	else
+	{
+		converted.m_values.assign(matrix.m_values.begin(), matrix.m_values.end());
+		std::vector<double>().swap(matrix.m_values);
+	}
+
+	return converted;
+}
+
+template <typename T>
+PomdpModel<T> POMDP_Writer::BuildModel(size_t idxTarget, size_t threads)
+{
+	if (!InitSave(idxTarget, threads))
+	{
+		return PomdpModel<T>();
+	}
+	size_t numStates = m_indexer.NumStates();
+
+	std::vector<CsrMatrix> transitions;
+	CalcTransitionMatrices(transitions);
+	// the observations of the output are known only after the reachable states are found
+	if (m_isPruned)
+	{
+		CalcReachable(transitions);
+	}
+	CsrMatrix observations = CalcObservationMatrix();
+	m_pool.reset();
+
+	// rewards and start (only live states are possible at start)
+	std::vector<double> rewards(numStates, 0.0);
+	rewards[m_indexer.WinIdx()] = s_winReward;
+	rewards[m_indexer.LossIdx()] = s_lossReward;
+
+	std::vector<double> start(numStates, 0.0);
+	for (const auto& entry : CalcStart())
+	{
+		start[entry.m_idx] = entry.m_p;
+	}
+
+	PomdpModel<T> model;
+	model.m_discount = m_discount;
+	// keep the rows of the reachable states (the columns of the observations are already the observations of the output)
+	if (m_isPruned)
+	{
+		for (auto & matrix : transitions)
+		{
+			matrix = m_reachable->Prune(matrix);
+		}
+		observations = m_reachable->PruneRows(observations);
+		rewards = m_reachable->Prune(rewards);
+		start = m_reachable->Prune(start);
+		model.m_stateIds = m_reachable->GetStates();
+	}
+
+	for (auto & matrix : transitions)
+	{
+		model.m_transitions.push_back(ConvertMatrix<T>(matrix));
+	}
+	model.m_observations = ConvertMatrix<T>(observations);
+	model.m_rewards.assign(rewards.begin(), rewards.end());
+	model.m_start.assign(start.begin(), start.end());
+
+	// names in the order of the idx of the output
+	size_t numObservations = m_indexer.NumLive() + m_indexer.NumDead();
+	for (size_t idx = 0; idx < numObservations; ++idx)
+	{
+		if (IsOutput(idx, "s"))
+		{
+			model.m_stateNames.push_back(StateName(idx, "s"));
+		}
+		if (IsOutput(idx, "o"))
+		{
+			model.m_observationNames.push_back(StateName(idx, "o"));
+		}
+	}
+	model.m_stateNames.push_back(s_WinState);
+	model.m_stateNames.push_back(s_LossState);
+	model.m_actionNames.assign(s_actions, s_actions + s_numActions);
+
+	m_reachable.reset();
+	return model;
+}
+
+template PomdpModel<float> POMDP_Writer::BuildModel<float>(size_t idxTarget, size_t threads);
+template PomdpModel<double> POMDP_Writer::BuildModel<double>(size_t idxTarget, size_t threads);
+
+BeliefFilter POMDP_Writer::CreateBeliefFilter(size_t idxTarget)
+{
+	bool isValid = InitSave(idxTarget, 1);
+
+	BeliefFilter::Dynamics dynamics(m_indexer);
+	dynamics.m_topology = m_topology;
+	if (!isValid)
+	{
+		return BeliefFilter(dynamics, std::vector<BeliefFilter::Entry>());
+	}
+	dynamics.m_selfFire = m_selfFire;
+	dynamics.m_enemyFire = m_enemyFire;
+	dynamics.m_idxTarget = idxTarget;
+	dynamics.m_selfPHit = m_self.GetPHit();
+	dynamics.m_enemyPHit = m_enemy.GetPHit();
+	dynamics.m_pObs = m_self.GetPObs();
+
+	// actions without a row of their own are the rows of all actions (stay)
+	dynamics.m_actions.assign(s_numActions, BeliefFilter::Action{ DIR_STAY, false });
+	dynamics.m_actions[ActionIdx("North")] = BeliefFilter::Action{ DIR_NORTH, false };
+	dynamics.m_actions[ActionIdx("South")] = BeliefFilter::Action{ DIR_SOUTH, false };
+	dynamics.m_actions[ActionIdx("East")] = BeliefFilter::Action{ DIR_EAST, false };
+	dynamics.m_actions[ActionIdx("West")] = BeliefFilter::Action{ DIR_WEST, false };
+	dynamics.m_actions[ActionIdx("Shoot_North")] = BeliefFilter::Action{ DIR_NORTH, true };
+	dynamics.m_actions[ActionIdx("Shoot_South")] = BeliefFilter::Action{ DIR_SOUTH, true };
+	dynamics.m_actions[ActionIdx("Shoot_East")] = BeliefFilter::Action{ DIR_EAST, true };
+	dynamics.m_actions[ActionIdx("Shoot_West")] = BeliefFilter::Action{ DIR_WEST, true };
+
+	// the same probabilities as the moves of the objects (see AddObjectsMovesRec)
+	dynamics.m_pStay.push_back(m_enemy.GetMovement().GetStay());
+	dynamics.m_pMove.push_back(m_enemy.GetMovement().GetEqual());
+	for (const auto& obj : m_NInvVector)
+	{
+		dynamics.m_pStay.push_back(obj.GetMovement().GetStay());
+		dynamics.m_pMove.push_back(obj.GetMovement().GetEqual());
+	}
+
+	size_t numCells = m_topology->GetNumCells();
+	dynamics.m_inObsRange.resize(numCells * (numCells + 1));
+	for (size_t self = 0; self < numCells; ++self)
+	{
+		for (size_t location = 0; location < numCells; ++location)
+		{
+			dynamics.m_inObsRange[self * (numCells + 1) + location] = InObsRange(static_cast<int>(self), static_cast<int>(location));
+		}
+		dynamics.m_inObsRange[self * (numCells + 1) + numCells] = InObsRange(static_cast<int>(self), DEAD_ENEMY);
+	}
+
+	std::vector<BeliefFilter::Entry> start;
+	for (const auto& entry : CalcStart())
+	{
+		start.push_back(BeliefFilter::Entry{ entry.m_idx, entry.m_p });
+	}
+
+	m_pool.reset();
+	return BeliefFilter(dynamics, start);
+}
+
+bool POMDP_Writer::InitSave(size_t idxTarget, size_t threads)
+{
+	m_idxTarget = idxTarget;
+	m_stats = GenerationStats();
+	m_reachable.reset();
+	m_indexer = StateIndexer(m_gridSize, 2 + m_NInvVector.size());
+	if (!m_indexer.IsValid())
+	{
+		m_stats.m_error = "Error " + std::to_string(m_indexer.GetNumObjects()) + " objects in grid " + std::to_string(m_gridSize) + " are not valid states";
+		return false;
+	}
+	m_pool.reset(threads > 1 ? new ThreadPool(threads) : nullptr);
+
+	m_shelterCells.clear();
+	for (const auto& v : m_shelter)
+	{
+		m_shelterCells.push_back(static_cast<int>(v.GetLocation().GetIdx(m_gridSize)));
+	}
+	if (nullptr != m_gridTables)
+	{
+		m_topology = m_gridTables->GetTopology(m_gridSize);
+		m_enemyFire = m_gridTables->GetLineOfFire(m_gridSize, m_shelterCells, m_enemy.GetRange());
+		m_selfFire = m_gridTables->GetLineOfFire(m_gridSize, m_shelterCells, m_self.GetRange());
+	}
+	else
+	{
+		m_enemyFire = std::make_shared<LineOfFire>(*m_topology, m_shelterCells, m_enemy.GetRange());
+		m_selfFire = std::make_shared<LineOfFire>(*m_topology, m_shelterCells, m_self.GetRange());
+	}
+	// the wildcard stays the same in both formats
+	m_actionNames.assign(1, "*");
+	for (size_t i = 0; i < s_numActions; ++i)
+	{
+		m_actionNames.push_back(m_isIndexed ? std::to_string(i) : s_actions[i]);
+	}
+
+	// the moves are calculated only if transitions are calculated (see CalcObjectsMoves)
+	m_movesOffset.clear();
+	return true;
+}
+
+void POMDP_Writer::WriteSection(ChunkBuffer& buffer, TextSection section, void (POMDP_Writer::*write)(ChunkBuffer&))
+{
+	// nothing is calculated after a failure
+	if (m_stats.IsFailed() || buffer.IsFailed())
+	{
+		m_stats.m_error = m_stats.IsFailed() ? m_stats.m_error : "Error Writing to file";
+		return;
+	}
+
+	if (nullptr == m_sectionCache)
+	{
+		(this->*write)(buffer);
+		return;
+	}
+
+	// the text before the section is written first so the section from the cache is in its place
+	uint64_t key = SectionKey(section);
+	buffer.Flush();
+	size_t bytesBefore = buffer.GetSink().GetBytesWritten();
+	SectionCache::ReadStatus status = m_sectionCache->Read(key, buffer.GetSink());
+	if (SectionCache::READ_FAILED == status)
+	{
+		m_stats.m_error = "Error Reading section cache";
+		return;
+	}
+	if (SectionCache::READ_DONE == status)
+	{
+		// the header from the cache is counted in the names (the start is also in the header)
+		GenerationStats::Section first = TEXT_HEADER == section ? GenerationStats::SECTION_NAMES : static_cast<GenerationStats::Section>(GenerationStats::SECTION_START + section);
+		GenerationStats::Section last = TEXT_HEADER == section ? GenerationStats::SECTION_START : first;
+		for (int s = first; s <= last; ++s)
+		{
+			m_stats.m_sections[s].m_isCached = true;
+		}
+		m_stats.m_sections[first].m_bytes += buffer.GetSink().GetBytesWritten() - bytesBefore;
+		return;
+	}
+
+	CacheSink entry(buffer.GetSink(), *m_sectionCache, key);
+	ChunkBuffer sectionBuffer(entry);
+	(this->*write)(sectionBuffer);
+	sectionBuffer.Flush();
+	if (sectionBuffer.IsFailed())
+	{
+		m_stats.m_error = "Error Writing to file";
+		return;
+	}
+	entry.Commit();
+}
+
+void POMDP_Writer::BeginSection(ChunkBuffer& buffer)
+{
+	m_sectionStart = std::chrono::steady_clock::now();
+	m_sectionBytes = buffer.GetBytesWritten();
+	m_counters = GenerationStats::Counters();
+}
+
+void POMDP_Writer::EndSection(GenerationStats::Section section, ChunkBuffer& buffer)
+{
+	GenerationStats::SectionStats& stats = m_stats.m_sections[section];
+	stats.m_seconds += SecondsSince(m_sectionStart);
+	stats.m_bytes += buffer.GetBytesWritten() - m_sectionBytes;
+	stats.m_counters += m_counters;
+}
+
+uint64_t POMDP_Writer::SectionKey(TextSection section)
+{
+	ContentHash hash;
+	auto addLocation = [&hash, this](const ObjInGrid& obj)
+	{
+		hash.Add(static_cast<uint64_t>(obj.GetLocation().GetIdx(m_gridSize)));
+		hash.Add(obj.GetLocation().GetStd());
+	};
+	auto addMovement = [&hash](const Move_Properties& movement)
+	{
+		hash.Add(movement.GetStay());
+		hash.Add(movement.GetEqual());
+		hash.Add(movement.GetToward());
+	};
+
+	// inputs of all the sections: the layout of the text and the states and observations that are written
+	hash.Add(s_textVersion);
+	hash.Add(static_cast<uint64_t>(section));
+	hash.Add(static_cast<uint64_t>(m_gridSize));
+	hash.Add(static_cast<uint64_t>(m_indexer.GetNumObjects()));
+	hash.Add(static_cast<uint64_t>(m_isIndexed));
+	hash.Add(static_cast<uint64_t>(m_precision));
+	if (nullptr != m_reachable)
+	{
+		hash.Add(m_reachable->GetStates().data(), m_reachable->GetStates().size() * sizeof(uint64_t));
+		hash.Add(m_observationIdx.data(), m_observationIdx.size() * sizeof(uint32_t));
+	}
+
+	switch (section)
+	{
+	case TEXT_HEADER:
+		// the comments (the target is only in the comments), the discount and the start
+		hash.Add(static_cast<uint64_t>(m_idxTarget));
+		hash.Add(m_discount);
+		addLocation(m_self);
+		addLocation(m_enemy);
+		for (const auto& v : m_NInvVector)
+		{
+			addLocation(v);
+		}
+		for (int cell : m_shelterCells)
+		{
+			hash.Add(static_cast<uint64_t>(cell));
+		}
+		hash.Add(m_startEpsilon);
+		hash.Add(static_cast<uint64_t>(m_isSparseStart));
+		break;
+	case TEXT_POSITIONS:
+	case TEXT_HITS:
+		// the moves of the objects, the shots of the enemy (and of the robot) and the win in the target
+		hash.Add(static_cast<uint64_t>(m_idxTarget));
+		addMovement(m_enemy.GetMovement());
+		for (const auto& v : m_NInvVector)
+		{
+			addMovement(v.GetMovement());
+		}
+		for (int cell : m_shelterCells)
+		{
+			hash.Add(static_cast<uint64_t>(cell));
+		}
+		hash.Add(static_cast<uint64_t>(m_enemy.GetRange()));
+		hash.Add(m_enemy.GetPHit());
+		if (TEXT_HITS == section)
+		{
+			hash.Add(static_cast<uint64_t>(m_self.GetRange()));
+			hash.Add(m_self.GetPHit());
+		}
+		break;
+	case TEXT_OBSERVATIONS:
+		hash.Add(static_cast<uint64_t>(m_self.GetRange()));
+		hash.Add(m_self.GetPObs());
+		break;
+	}
+
+	return hash.GetKey();
+}
+
+void POMDP_Writer::CalcTransitionMatrices(std::vector<CsrMatrix>& transitions)
+{
+	CalcObjectsMoves();
+
+	// collect the entries of the transitions (no text is written while collecting)
+	SparseModelBuilder model(s_numActions, m_indexer.NumStates());
+	m_model = &model;
+	MemorySink noText;
+	ChunkBuffer buffer(noText);
+	if (m_isSymmetric)
+	{
+		CalcSymmetricTransitions(buffer);
+	}
+	else
+	{
+		CalcPositions(buffer);
+		CalcHits(buffer);
+	}
+	m_model = nullptr;
+
+	transitions.resize(s_numActions);
+	for (size_t a = 0; a < s_numActions; ++a)
+	{
+		transitions[a] = model.BuildTransitions(a);
+	}
+}
+
+CsrMatrix POMDP_Writer::CalcObservationMatrix()
+{
+	// collect the entries of the observations (no text is written while collecting)
+	SparseModelBuilder model(s_numActions, m_indexer.NumStates());
+	m_model = &model;
+	MemorySink noText;
+	ChunkBuffer buffer(noText);
+	CalcObs(buffer);
+	m_model = nullptr;
+
+	return model.BuildObservations(nullptr != m_reachable ? m_numObservations : m_indexer.NumLive() + m_indexer.NumDead());
+}
+
+void POMDP_Writer::CalcReachable(const std::vector<CsrMatrix>& transitions)
+{
+	std::vector<size_t> startStates;
+	for (const auto& entry : CalcStart())
+	{
+		startStates.push_back(entry.m_idx);
+	}
+	m_reachable.reset(new Reachability(transitions, startStates, { m_indexer.WinIdx(), m_indexer.LossIdx() }));
+
+	// the robot is observed in its location so an observation is written if a reachable state has the same robot location
+	size_t numObservations = m_indexer.NumLive() + m_indexer.NumDead();
+	std::vector<bool> isObserved(m_topology->GetNumCells(), false);
+	for (size_t idx = 0; idx < numObservations; ++idx)
+	{
+		if (m_reachable->IsReachable(idx))
+		{
+			isObserved[m_indexer.GetSelf(idx)] = true;
+		}
+	}
+
+	m_observationIdx.assign(numObservations, Reachability::s_unreachable);
+	m_numObservations = 0;
+	for (size_t idx = 0; idx < numObservations; ++idx)
+	{
+		if (isObserved[m_indexer.GetSelf(idx)])
+		{
+			m_observationIdx[idx] = static_cast<uint32_t>(m_numObservations++);
+		}
+	}
+}
+
+size_t POMDP_Writer::OutputIdx(size_t idx, const char *type) const
 {
-		std::string buffer("");
-		s_idxTarget = idxTarget;
+	if (nullptr == m_reachable)
+	{
+		return idx;
+	}
+
+	return 'o' == type[0] ? m_observationIdx[idx] : m_reachable->GetNewIdx(idx);
+}
+
+void POMDP_Writer::RunShards(size_t numShards, const calcShard_t& calcShard, ChunkBuffer& buffer)
+{
+	if (nullptr == m_pool)
+	{
+		Context ctx;
+		ctx.m_model = m_model;
+		for (size_t i = 0; i < numShards; ++i)
+		{
+			calcShard(i, buffer, ctx);
+		}
+		m_counters += ctx.m_counters;
+		return;
+	}
 
-		//add comments and init lines(state observations etc.) to file
-		CommentsAndInitLines(buffer, fptr);
-		
-		// add position with and without moving of the robot
-		PositionStates(buffer, fptr);
+	// each shard is calculated to its own memory buffer (and model) and the buffers are merged in the order of the shards.
+	// only a window of shards is calculated at once so the memory stays bounded
+	struct ShardResult
+	{
+		std::future<void> m_done;
+		std::unique_ptr<MemorySink> m_sink;
+		std::unique_ptr<SparseModelBuilder> m_model;
+		std::unique_ptr<GenerationStats::Counters> m_counters;
+	};
+	size_t window = 2 * m_pool->GetNumThreads();
+	std::deque<ShardResult> inCalc;
+	size_t next = 0;
+
+	auto submitNext = [&]()
+	{
+		ShardResult result;
+		result.m_sink.reset(new MemorySink);
+		if (nullptr != m_model)
+		{
+			result.m_model.reset(new SparseModelBuilder(m_model->GetNumActions(), m_model->GetNumStates()));
+		}
+		result.m_counters.reset(new GenerationStats::Counters);
+		MemorySink *pSink = result.m_sink.get();
+		SparseModelBuilder *pModel = result.m_model.get();
+		GenerationStats::Counters *pCounters = result.m_counters.get();
+		size_t shard = next++;
+		result.m_done = m_pool->Submit([&calcShard, pSink, pModel, pCounters, shard]()
+		{
+			Context ctx;
+			ctx.m_model = pModel;
+			ChunkBuffer shardBuffer(*pSink);
+			calcShard(shard, shardBuffer, ctx);
+			*pCounters = ctx.m_counters;
+		});
+		inCalc.push_back(std::move(result));
+	};
+
+	for (; next < numShards && inCalc.size() < window;)
+	{
+		submitNext();
+	}
 
-		// add hits calculation
-		AttackAction(buffer, fptr);
+	while (!inCalc.empty())
+	{
+		inCalc.front().m_done.get();
+		m_stats.m_peakBufferSize = std::max<uint64_t>(m_stats.m_peakBufferSize, inCalc.front().m_sink->GetData().size());
+		m_counters += *inCalc.front().m_counters;
+		buffer += inCalc.front().m_sink->GetData();
+		if (nullptr != m_model)
+		{
+			m_model->Append(*inCalc.front().m_model);
+		}
+		inCalc.pop_front();
 
-		// add observations and rewards
-		ObservationsAndRewards(buffer, fptr);
+		if (next < numShards)
+		{
+			submitNext();
+		}
+	}
 }
 
-void POMDP_Writer::CommentsAndInitLines(std::string buffer, FILE *fptr)
+void POMDP_Writer::CommentsAndInitLines(ChunkBuffer& buffer)
 {
 	// add comments
 	buffer += "# pomdp file:\n";
-	buffer += "# grid size: " + std::to_string(m_gridSize) + "  target idx: " + std::to_string(s_idxTarget);
+	buffer += "# grid size: " + std::to_string(m_gridSize) + "  target idx: " + std::to_string(m_idxTarget);
 	buffer += "\n# self initial location: " + std::to_string(m_self.GetLocation().GetIdx(m_gridSize)) + " std = " + std::to_string(m_self.GetLocation().GetStd());
 	buffer += "\n# enemy initial location: " + std::to_string(m_enemy.GetLocation().GetIdx(m_gridSize)) + " std = " + std::to_string(m_enemy.GetLocation().GetStd());
 	for (auto v : m_NInvVector)
@@ -99,7 +804,7 @@ void POMDP_Writer::CommentsAndInitLines(std::string buffer, FILE *fptr)
 		buffer += "\n# non- involved initial location: " + std::to_string(v.GetLocation().GetIdx(m_gridSize)) + " std = " + std::to_string(v.GetLocation().GetStd());
 	}
 
-	for (auto v : m_shelter)
+	for (const auto& v : m_shelter)
 	{
 		buffer += "\n# shelter location: " + std::to_string(v.GetLocation().GetIdx(m_gridSize));
 	}
@@ -108,106 +813,158 @@ void POMDP_Writer::CommentsAndInitLines(std::string buffer, FILE *fptr)
 	buffer += "\n\ndiscount: " + std::to_string(m_discount);
 	buffer += "\nvalues: reward\nstates: ";
 
-	// add states names
-	std::string type = "s";
-	CalcStatesAndObs(2 + m_NInvVector.size(), m_gridSize, type, buffer);
-	buffer += s_WinState + " " + s_LossState + "\n";
-	buffer += "actions: Stay North South East West Shoot_North Shoot_South Shoot_West Shoot_East\n";
+	if (m_isIndexed)
+	{
+		// add number of states, actions and observations (observations are all states except win and loss)
+		bool isPruned = nullptr != m_reachable;
+		buffer += std::to_string(isPruned ? m_reachable->GetNumReachable() : m_indexer.NumStates()) + "\n";
+		buffer += "actions: " + std::to_string(s_numActions) + "\n";
+		buffer += "observations: " + std::to_string(isPruned ? m_numObservations : m_indexer.NumLive() + m_indexer.NumDead()) + "\n";
+	}
+	else
+	{
+		// add states names
+		BeginSection(buffer);
+		std::string type = "s";
+		CalcStatesAndObs(type, buffer);
+		buffer += s_WinState + " " + s_LossState + "\n";
+		buffer += "actions:";
+		for (size_t i = 0; i < s_numActions; ++i)
+		{
+			buffer += " " + s_actions[i];
+		}
+		buffer += "\n";
 
-	// add observations names
-	buffer += "observations: ";
-	type = "o";
-	CalcStatesAndObs(2 + m_NInvVector.size(), m_gridSize, type, buffer);
-	buffer += "\n\nstart: \n";
+		// add observations names
+		buffer += "observations: ";
+		type = "o";
+		CalcStatesAndObs(type, buffer);
+		EndSection(GenerationStats::SECTION_NAMES, buffer);
+	}
+	buffer += "\n\n";
 
 	// add start states probability
+	BeginSection(buffer);
 	CalcStartState(buffer);
+	EndSection(GenerationStats::SECTION_START, buffer);
 	//save to file
-	auto err = fputs(buffer.c_str(), fptr);
-	if (err < 0) { std::cerr << "Error Writing to file\n"; exit(1); }
+	buffer.Flush();
 }
 
-void POMDP_Writer::PositionStates(std::string buffer, FILE * fptr)
+void POMDP_Writer::PositionStates(ChunkBuffer& buffer)
 {
+	BeginSection(buffer);
+	CalcObjectsMoves();
 	buffer += "\n\nT: * : * : * 0.0\n\n";
+	CalcPositions(buffer);
+	EndSection(GenerationStats::SECTION_POSITIONS, buffer);
+	// save to file
+	buffer.Flush();
+}
+
+void POMDP_Writer::CalcPositions(ChunkBuffer& buffer)
+{
+	std::vector<PositionShard> shards;
 	// add move positions when the robot is static
-	NoMovePosition(buffer);
+	NoMovePosition(shards);
 	// add move positions when robot is moving
-	MovePosition(buffer);
-	// save to file
-	auto err = fputs(buffer.c_str(), fptr);
-	if (err < 0) { std::cerr << "Error Writing to file\n"; exit(1);}
+	MovePosition(shards);
+
+	// calculate the positions of each robot location and action
+	RunShards(shards.size(), [this, &shards](size_t shard, ChunkBuffer& shardBuffer, Context& ctx)
+	{
+		CalcPositionSelf(shards[shard].m_self, shards[shard].m_newSelf, shards[shard].m_action, shardBuffer, ctx);
+	}, buffer);
 }
 
-void POMDP_Writer::AttackAction(std::string buffer, FILE * fptr)
+void POMDP_Writer::AttackAction(ChunkBuffer& buffer)
 {
+	BeginSection(buffer);
+	CalcObjectsMoves();
 	// calculate states and probability to hit
 	CalcHits(buffer);
+	EndSection(GenerationStats::SECTION_HITS, buffer);
 	// save to file
-	auto err = fputs(buffer.c_str(), fptr);
-	if (err < 0) { std::cerr << "Error Writing to file\n"; exit(1); }
+	buffer.Flush();
 }
 
-void POMDP_Writer::ObservationsAndRewards(std::string buffer, FILE * fptr)
+void POMDP_Writer::ObservationsAndRewards(ChunkBuffer& buffer)
 {
 	// calculate observations
+	BeginSection(buffer);
 	CalcObs(buffer);
+	EndSection(GenerationStats::SECTION_OBSERVATIONS, buffer);
 	// add rewards
-	buffer += "\n\nR: * : * : * : * 0.0\nR: * : "
-		+ s_WinState + " : * : * 100\nR: * : "
-		+ s_LossState + " : * : * -100\n";
+	buffer += "\n\nR: * : * : * : * 0.0\nR: * : " + m_winName + " : * : * ";
+	buffer.AppendGeneral(s_winReward, s_startPrecision);
+	buffer += "\nR: * : " + m_lossName + " : * : * ";
+	buffer.AppendGeneral(s_lossReward, s_startPrecision);
+	buffer += '\n';
 	// save to file 
-	auto err = fputs(buffer.c_str(), fptr);
-	if (err < 0) { std::cerr << "Error Writing to file\n"; return; }
+	buffer.Flush();
 }
 
-void POMDP_Writer::CalcStatesAndObs(size_t numObjects, size_t gridSize, std::string& type, std::string& buffer)
+void POMDP_Writer::CalcStatesAndObs(std::string& type, ChunkBuffer& buffer)
 {
-	state_t stateVec(numObjects);
-
-	CalcS_ORec(stateVec, 0, gridSize, type, buffer);
+	state_t stateVec(m_indexer.GetNumObjects());
 
-	// add states or observations for dead enemy
-	stateVec[1] = DEAD_ENEMY;
-	for (size_t i = 0; i < gridSize * gridSize; ++i)
+	// run on all live states and then on all states with dead enemy (same order as the states idx)
+	for (size_t idx = 0; idx < m_indexer.NumLive() + m_indexer.NumDead(); ++idx)
 	{
-		stateVec[0] = i;
-		CalcS_ORec(stateVec, 2, gridSize, type, buffer);
+		if (!IsOutput(idx, type.c_str()))
+		{
+			continue;
+		}
+		m_indexer.Unrank(idx, &stateVec[0]);
+		// insert state to buffer
+		++m_counters.m_states;
+		AppendStateName(buffer, &stateVec[0], type.c_str());
+		buffer += ' ';
 	}
 }
 
-void POMDP_Writer::CalcS_ORec(state_t& stateVec, size_t currIdx, size_t gridSize, std::string & type, std::string & buffer)
+bool POMDP_Writer::WriteNames(OutputSink& sink)
 {
-	// stopping condition when finish running on all objects
-	if (stateVec.size() == currIdx)
+	ChunkBuffer buffer(sink);
+	state_t stateVec(m_indexer.GetNumObjects());
+
+	// write line of idx and name for each state, action and observation
+	buffer += "states:\n";
+	for (size_t idx = 0; idx < m_indexer.NumLive() + m_indexer.NumDead(); ++idx)
 	{
-		// insert state to buffer
-		buffer += type;
-		for (size_t i = 0; i < stateVec.size() - 1; ++i)
+		if (IsOutput(idx, "s"))
 		{
-			if (stateVec[i] == DEAD_ENEMY)
-			{
-				buffer += "Dx";
-			}
-			else
-			{
-				buffer += std::to_string(stateVec[i]) + "x";
-			}
+			m_indexer.Unrank(idx, &stateVec[0]);
+			buffer.AppendInteger(OutputIdx(idx, "s"));
+			buffer += ' ';
+			AppendStateName(buffer, &stateVec[0], "s");
+			buffer += '\n';
 		}
-		buffer += std::to_string(stateVec[stateVec.size() - 1]) + " ";
 	}
-	else
+	buffer += m_winName + " " + s_WinState + "\n";
+	buffer += m_lossName + " " + s_LossState + "\n";
+
+	buffer += "actions:\n";
+	for (size_t i = 0; i < s_numActions; ++i)
+	{
+		buffer += std::to_string(i) + " " + s_actions[i] + "\n";
+	}
+
+	buffer += "observations:\n";
+	for (size_t idx = 0; idx < m_indexer.NumLive() + m_indexer.NumDead(); ++idx)
 	{
-		// run on all possible states (without repetitions)
-		for (size_t i = 0; i < gridSize * gridSize; ++i)
+		if (IsOutput(idx, "o"))
 		{
-			stateVec[currIdx] = i;
-			if (NoRepetition(stateVec, currIdx))
-			{
-				CalcS_ORec(stateVec, currIdx + 1, gridSize, type, buffer);
-			}
+			m_indexer.Unrank(idx, &stateVec[0]);
+			buffer.AppendInteger(OutputIdx(idx, "o"));
+			buffer += ' ';
+			AppendStateName(buffer, &stateVec[0], "o");
+			buffer += '\n';
 		}
 	}
+
+	buffer.Flush();
+	return !buffer.IsFailed() && sink.Flush();
 }
 
 
@@ -223,122 +980,122 @@ bool POMDP_Writer::NoRepetition(state_t& stateVec, size_t currIdx)
 	return true;
 }
 
-void POMDP_Writer::NoRepetitionCheckAndCorrect(state_t& stateVec, int *moveStates, size_t *arrOfIdx)
+void POMDP_Writer::NoRepetitionCheckAndCorrect(int *stateVec, size_t size, const int *origins, int selfOrigin)
 {
-	//if any move state equal to the robot location change location to previous location
-	for (size_t i = 1; i < stateVec.size(); ++i)
+	// each correction returns an object (or the robot) to its previous location. the previous locations are different
+	// from each other so the corrections end when all repetitions are gone (at most one correction per object)
+	bool isCorrected = true;
+	while (isCorrected)
 	{
-		if (stateVec[i] == stateVec[0])
-		{
-			stateVec[i] = moveStates[(i - 1) * 5] ;
-		}
-	}
+		isCorrected = false;
 
-	//if one of the stateVec equal to another return the possible state to the previous location
-	for (size_t i = 1; i < stateVec.size(); ++i)
-	{
-		for (size_t j = 1; j < stateVec.size(); ++j)
+		//if any move state equal to the robot location change location to previous location
+		//(if the object is in its previous location the robot can't move to this location and return to its previous location)
+		for (size_t i = 1; i < size; ++i)
 		{
-			if (stateVec[i] == stateVec[j] && i != j)
+			if (stateVec[i] == stateVec[0])
 			{
-				if (arrOfIdx[i - 1] % 5 == 0)
+				if (stateVec[i] == origins[i - 1])
 				{
-					stateVec[j] = moveStates[(j - 1) * 5];
+					stateVec[0] = selfOrigin;
 				}
 				else
 				{
-					stateVec[i] = moveStates[(i - 1) * 5];
+					stateVec[i] = origins[i - 1];
+				}
+				isCorrected = true;
+			}
+		}
+
+		//if one of the stateVec equal to another return the object that moved to the previous location
+		for (size_t i = 1; i < size; ++i)
+		{
+			for (size_t j = 1; j < size; ++j)
+			{
+				if (stateVec[i] == stateVec[j] && i != j)
+				{
+					if (stateVec[i] == origins[i - 1])
+					{
+						stateVec[j] = origins[j - 1];
+					}
+					else
+					{
+						stateVec[i] = origins[i - 1];
+					}
+					isCorrected = true;
 				}
 			}
 		}
 	}
 }
 
-double POMDP_Writer::DividePRepetitions(state_t& stateVec, double * pMat, int currIdx, size_t numStates)
+void POMDP_Writer::CalcStartState(ChunkBuffer& buffer)
 {
-	// run on all states until current and add the p from the non-valid idx (i.e. current location cannot be equal to previous objects location)
-	double pToDivide = 0;
-	for (int i = 0; i < currIdx; ++i)
+	std::vector<StartDistribution::Entry> entries = CalcStart();
+	m_counters.m_states += entries.size();
+
+	// a start that is uniform on its states is written as the states
+	bool isUniform = !entries.empty();
+	for (size_t i = 1; i < entries.size() && isUniform; ++i)
+	{
+		isUniform = entries[i].m_p == entries[0].m_p;
+	}
+	if (m_isSparseStart && isUniform)
 	{
-		pToDivide += pMat[stateVec[i]];
+		buffer += 1 == entries.size() ? "start:" : "start include:";
+		for (const auto& entry : entries)
+		{
+			buffer += ' ';
+			AppendState(buffer, entry.m_idx, "s");
+		}
+		return;
 	}
 
-	// add to each slot equal share of the non-valid probability
-	pToDivide /= (numStates - currIdx);
-	for (size_t i = 0; i < numStates; ++i)
+	buffer += "start: \n";
+	int precision = TextFormat::s_shortest == m_precision ? TextFormat::s_shortest : s_startPrecision;
+	size_t idx = 0;
+	for (const auto& entry : entries)
 	{
-		pMat[i] += pToDivide;
+		for (; idx < entry.m_idx; ++idx)
+		{
+			if (IsOutput(idx, "s"))
+			{
+				buffer += "0 ";
+			}
+		}
+		buffer.AppendGeneral(entry.m_p, precision);
+		buffer += ' ';
+		++idx;
 	}
 
-	return pToDivide;
+	// the rest of the live states, the states where the enemy is dead and lose/win states are not possible at start
+	for (; idx < m_indexer.NumStates(); ++idx)
+	{
+		if (IsOutput(idx, "s"))
+		{
+			buffer += "0 ";
+		}
+	}
 }
 
-void POMDP_Writer::ReturnPRepetition(double *pMat, size_t numStates, double pRep)
+std::vector<StartDistribution::Entry> POMDP_Writer::CalcStart()
 {
-	// return the p that added earlier from DividePRepetitions()
-	for (size_t i = 0; i < numStates; ++i)
-	{
-		pMat[i] -= pRep;
-	}
+	std::vector<double> pMat;
+	CalcObjectsPosition(pMat);
+	return StartDistribution(m_indexer, m_gridSize * m_gridSize, &pMat[0], m_startEpsilon).GetEntries();
 }
 
-void POMDP_Writer::CalcStartState(std::string& buffer)
+void POMDP_Writer::CalcObjectsPosition(std::vector<double>& pMat)
 {
 	size_t statesForObj = m_gridSize * m_gridSize;
-	double * pMat(new double[statesForObj * (2 + m_NInvVector.size()) + 1]);
+	pMat.resize(statesForObj * (2 + m_NInvVector.size()));
 
 	// calculate individual probability matrix for each object
-	CalcSinglePosition(&m_self, m_gridSize, pMat);
-	CalcSinglePosition(&m_enemy, m_gridSize, pMat + statesForObj);
+	CalcSinglePosition(&m_self, m_gridSize, &pMat[0]);
+	CalcSinglePosition(&m_enemy, m_gridSize, &pMat[statesForObj]);
 	for (size_t i = 0 ; i < m_NInvVector.size() ; ++i)
 	{
-		CalcSinglePosition(&m_NInvVector[i], m_gridSize, pMat + (i + 2) * statesForObj);
-	}
-
-	state_t stateVec(2 + m_NInvVector.size());
-	// calculate probability for each state
-	CalcStartStateRec(pMat, stateVec, 0, buffer);
-
-	// add the p to start in states where the enemy dead and in lose/win states
-	size_t numNonInitStates = statesForObj;
-	for (size_t i = 0; i < m_NInvVector.size(); ++i)
-	{
-		numNonInitStates *= statesForObj;
-	}
-	for (size_t i = 0; i < numNonInitStates + 2; ++i)
-	{
-		buffer += "0 ";
-	}
-	delete[] pMat;
-}
-
-void POMDP_Writer::CalcStartStateRec(double * pMat, state_t& stateVec, size_t currIdx, std::string & buffer)
-{
-	// stopping condition when finish running on all objects
-	if (stateVec.size() == currIdx)
-	{
-		// the probability of the state is the multiplication of each object location probability
-		double p = 1;
-		for (size_t i = 0; i < stateVec.size(); ++i)
-		{
-			p *= pMat[stateVec[i] + i * m_gridSize * m_gridSize];
-		}
-		buffer += to_string_precision(p) + " ";
-	}
-	else
-	{
-		// to avoid repetition in state (s0x0) divide the probability of repeated location in all other locations
-		double pRep = DividePRepetitions(stateVec, pMat + currIdx * m_gridSize * m_gridSize, currIdx, m_gridSize * m_gridSize);
-		for (size_t i = 0; i < m_gridSize * m_gridSize; ++i)
-		{
-			stateVec[currIdx] = i;
-			if (NoRepetition(stateVec, currIdx))
-			{
-				CalcStartStateRec(pMat, stateVec, currIdx + 1, buffer);
-			}
-		}
-		// return the pMat to previous values
-		ReturnPRepetition(pMat + currIdx * m_gridSize * m_gridSize, m_gridSize * m_gridSize, pRep);
+		CalcSinglePosition(&m_NInvVector[i], m_gridSize, &pMat[(i + 2) * statesForObj]);
 	}
 }
 
@@ -351,39 +1108,39 @@ void POMDP_Writer::CalcSinglePosition(ObjInGrid *obj, size_t gridSize, double *p
 		return;
 	}
 
-	double * P_x(new double[gridSize]);
-	double * P_y(new double[gridSize]);
-	double leftx = 1.0;
-	double lefty = 1.0;
-	double cdf;
-
-	// compute the cdf(x + 0.5) - cdf( (x - 1) + 0.5 ) --> the p(x)
-	// do the same thing for y
-	for (size_t i = 0 ; i < gridSize; ++i)
-	{
-		cdf = CumulativeDistFunc(i + 0.5, obj->GetLocation().GetX(), obj->GetLocation().GetStd());
-		P_x[i]  = leftx - cdf;
-		leftx = cdf;
-
-		cdf = CumulativeDistFunc(i + 0.5, obj->GetLocation().GetY(), obj->GetLocation().GetStd());
-		P_y[i] = lefty - cdf;
-		lefty = cdf;
-	}
-	// insert the edges of the distribution to the edges
-	P_x[gridSize - 1] += leftx;
-	P_y[gridSize - 1] += lefty;
+	std::vector<double> P_x(gridSize);
+	std::vector<double> P_y(gridSize);
+	CalcAxisPosition(obj->GetLocation().GetX(), obj->GetLocation().GetStd(), gridSize, &P_x[0]);
+	CalcAxisPosition(obj->GetLocation().GetY(), obj->GetLocation().GetStd(), gridSize, &P_y[0]);
 
-	// calculate pmat in vectoric multiplication of the probability vectors
+	// calculate pmat as the outer product of the probability vectors (each row is P_x scaled by P_y[y])
 	for (size_t y = 0; y < gridSize; ++y)
 	{
+		double *row = pMat + y * gridSize;
 		for (size_t x = 0; x < gridSize; ++x)
 		{
-			pMat[y * (gridSize) + x] = P_x[x] * P_y[y];
+			row[x] = P_x[x] * P_y[y];
 		}
 	}
+}
+
+void POMDP_Writer::CalcAxisPosition(int mean, double std, size_t gridSize, double *p)
+{
+	// compute the cdf of all the borders between the cells (p is used for the cdf) and then the difference of each two borders
+	for (size_t i = 0; i < gridSize; ++i)
+	{
+		p[i] = CumulativeDistFunc(i + 0.5, mean, std);
+	}
 
-	delete[] P_x;
-	delete[] P_y;
+	double left = 1.0;
+	for (size_t i = 0; i < gridSize; ++i)
+	{
+		double cdf = p[i];
+		p[i] = left - cdf;
+		left = cdf;
+	}
+	// insert the edges of the distribution to the edges
+	p[gridSize - 1] += left;
 }
 
 void POMDP_Writer::CalcSinglePositionNoStd(ObjInGrid * obj, size_t gridSize, double * pMat)
@@ -393,7 +1150,7 @@ void POMDP_Writer::CalcSinglePositionNoStd(ObjInGrid * obj, size_t gridSize, dou
 	{
 			pMat[i] = 0;
 	}
-	pMat[obj->GetLocation().GetY() * (gridSize - 1) + obj->GetLocation().GetX()] = 1;
+	pMat[obj->GetLocation().GetIdx(gridSize)] = 1;
 }
 
 double POMDP_Writer::CumulativeDistFunc(double x, int mean, double std)
@@ -402,300 +1159,374 @@ double POMDP_Writer::CumulativeDistFunc(double x, int mean, double std)
 	return 0.5 * erfc((x - mean) / (std * sqrt(2)) );
 }
 
-void POMDP_Writer::NoMovePosition(std::string & buffer)
+void POMDP_Writer::NoMovePosition(std::vector<PositionShard>& shards)
 {
-	state_t stateVec(2 + m_NInvVector.size());
-	std::string action = "*";
-	CalcPositionRec(stateVec, stateVec, 0, action, buffer);
+	for (size_t i = 0; i < m_gridSize * m_gridSize; ++i)
+	{
+		shards.push_back(PositionShard{ static_cast<int>(i), static_cast<int>(i), ALL_ACTIONS });
+	}
 }
 
-void POMDP_Writer::MovePosition(std::string & buffer)
+void POMDP_Writer::MovePosition(std::vector<PositionShard>& shards)
 {
-	std::vector<int>toExclude;
+	MovePositionSingleDirection(shards, DIR_NORTH, ActionIdx("North"));
+	MovePositionSingleDirection(shards, DIR_SOUTH, ActionIdx("South"));
+	MovePositionSingleDirection(shards, DIR_WEST, ActionIdx("West"));
+	MovePositionSingleDirection(shards, DIR_EAST, ActionIdx("East"));
+}
 
-	for (size_t i = 0; i < m_gridSize; ++i)
+void POMDP_Writer::MovePositionSingleDirection(std::vector<PositionShard>& shards, GridDirection direction, int action)
+{
+	// run on all possible location of the robot, if the move from the location will be possible calculate moves from the position
+	for (int i = 0; i < static_cast<int>(m_topology->GetNumCells()); ++i)
 	{
-		toExclude.push_back(i);
+		if (m_topology->IsValidMove(i, direction))
+		{
+			shards.push_back(PositionShard{ i, m_topology->GetNeighbor(i, direction), action });
+		}
 	}
-	toExclude.push_back(-1);
+}
 
-	std::string north = "North";
-	MovePositionSingleDirection(buffer, -1 * m_gridSize, toExclude.begin(), north);
 
-	for (size_t i = 0; i < m_gridSize; ++i)
-	{
-		toExclude[i] = m_gridSize * (m_gridSize - 1) + i;
-	}
-	std::string south = "South";
-	MovePositionSingleDirection(buffer, m_gridSize, toExclude.begin(), south);
+void POMDP_Writer::CalcSymmetricTransitions(ChunkBuffer& buffer)
+{
+	GridSymmetry symmetry(*m_topology);
+	int target = m_idxTarget < m_topology->GetNumCells() ? static_cast<int>(m_idxTarget) : -1;
+	std::vector<size_t> symmetries = symmetry.Preserving(target, m_shelterCells);
 
-	for (size_t i = 0; i < m_gridSize; ++i)
+	std::vector<std::vector<uint32_t>> stateMaps(symmetries.size());
+	std::vector<std::vector<int>> actionMaps(symmetries.size());
+	for (size_t i = 0; i < symmetries.size(); ++i)
 	{
-		toExclude[i] = m_gridSize * i;
+		CalcStateMap(symmetry, symmetries[i], stateMaps[i]);
+		CalcActionMap(symmetry, symmetries[i], actionMaps[i]);
 	}
-	std::string west = "West";
-	MovePositionSingleDirection(buffer, -1, toExclude.begin(), west);
 
-	for (size_t i = 0; i < m_gridSize; ++i)
+	// a robot location is calculated if it is the lowest location of its orbit
+	std::vector<int> canonical;
+	for (int cell = 0; cell < static_cast<int>(m_topology->GetNumCells()); ++cell)
 	{
-		toExclude[i] = m_gridSize * (i + 1) - 1;
+		bool isLowest = true;
+		for (size_t s : symmetries)
+		{
+			isLowest &= symmetry.MapCell(s, cell) >= cell;
+		}
+		if (isLowest)
+		{
+			canonical.push_back(cell);
+		}
 	}
-	std::string east = "East";
-	MovePositionSingleDirection(buffer, 1, toExclude.begin(), east);
-}
 
-void POMDP_Writer::MovePositionSingleDirection(std::string & buffer, int advanceFactor, std::vector<int>::iterator toExclude, std::string & action)
-{
-	state_t stateVec(2 + m_NInvVector.size());
-	state_t newStateVec(2 + m_NInvVector.size());
-	
-	// run on all possible location of the robot, if the move from the location will be possible calculate moves from the position
-	for (size_t i = 0; i < m_gridSize * m_gridSize; ++i)
+	RunShards(canonical.size(), [&](size_t shard, ChunkBuffer& shardBuffer, Context& ctx)
 	{
-		// insert current location of the robot
-		stateVec[0] = i;
-		newStateVec[0] = i + advanceFactor;
-
-		// rely that the order of toExclude will be the same as the order of appearence of non-valid moves in i
-		if (i != *toExclude)
+		int self = canonical[shard];
+		SparseModelBuilder orbit(s_numActions, m_indexer.NumStates());
+		SparseModelBuilder *model = ctx.m_model;
+		ctx.m_model = &orbit;
+
+		// the same rows as the shards of CalcPositions and CalcHits for the robot location
+		CalcPositionSelf(self, self, ALL_ACTIONS, shardBuffer, ctx);
+		for (int action = ActionIdx("North"); action <= ActionIdx("West"); ++action)
 		{
-			CalcPositionRec(stateVec, newStateVec, 1, action, buffer);
+			if (m_topology->IsValidMove(self, s_actionDirections[action]))
+			{
+				CalcPositionSelf(self, m_topology->GetNeighbor(self, s_actionDirections[action]), action, shardBuffer, ctx);
+			}
 		}
-		else
+		CalcHitsSelf(self, shardBuffer, ctx);
+		ctx.m_model = model;
+
+		// each location of the orbit gets the rows permuted by the first symmetry that maps the robot location to it
+		std::vector<int> images;
+		for (size_t i = 0; i < symmetries.size(); ++i)
 		{
-			++toExclude;
+			int image = symmetry.MapCell(symmetries[i], self);
+			if (std::find(images.begin(), images.end(), image) == images.end())
+			{
+				images.push_back(image);
+				model->AppendPermuted(orbit, &stateMaps[i][0], &actionMaps[i][0]);
+			}
 		}
-	}
+	}, buffer);
 }
 
-
-void POMDP_Writer::CalcPositionRec(state_t & originalStateVec, state_t & newStateVec, size_t currObj, std::string & action, std::string & buffer)
+void POMDP_Writer::CalcStateMap(const GridSymmetry& symmetry, size_t s, std::vector<uint32_t>& stateMap) const
 {
-	if (currObj == newStateVec.size())
+	stateMap.resize(m_indexer.NumStates());
+	state_t stateVec(m_indexer.GetNumObjects());
+	for (size_t idx = 0; idx < m_indexer.WinIdx(); ++idx)
 	{
-		if (InEnemyRange(originalStateVec))
+		m_indexer.Unrank(idx, &stateVec[0]);
+		for (auto & location : stateVec)
 		{
-			buffer += "T: " + action + " : " + GetCurrentState(originalStateVec) + " : " + s_LossState + " " + std::to_string(m_enemy.GetPHit()) + "\n";
-			s_pLeftProbability = 1 - m_enemy.GetPHit();
+			location = DEAD_ENEMY == location ? DEAD_ENEMY : symmetry.MapCell(s, location);
 		}
-		PositionSingleState(newStateVec, GetCurrentState(originalStateVec), action, buffer);
-		buffer += "\n";
-		s_pLeftProbability = 1;
+		stateMap[idx] = static_cast<uint32_t>(m_indexer.Rank(&stateVec[0]));
 	}
-	else
+	stateMap[m_indexer.WinIdx()] = static_cast<uint32_t>(m_indexer.WinIdx());
+	stateMap[m_indexer.LossIdx()] = static_cast<uint32_t>(m_indexer.LossIdx());
+}
+
+void POMDP_Writer::CalcActionMap(const GridSymmetry& symmetry, size_t s, std::vector<int>& actionMap)
+{
+	// a move is mapped to the move in the mapped direction and a shot to the shot in the mapped direction
+	int firstShot = ActionIdx("Shoot_North");
+	actionMap.assign(1, ALL_ACTIONS);
+	for (int action = 0; action < static_cast<int>(s_numActions); ++action)
 	{
-		for (size_t i = 0; i < m_gridSize * m_gridSize; ++i)
+		GridDirection direction = symmetry.MapDirection(s, s_actionDirections[action]);
+		int mapped = action;
+		for (int other = 0; other < static_cast<int>(s_numActions); ++other)
 		{
-			originalStateVec[currObj] = i;
-			newStateVec[currObj] = i;
-			if (NoRepetition(originalStateVec, currObj))
+			if (DIR_STAY != direction && s_actionDirections[other] == direction && (other >= firstShot) == (action >= firstShot))
 			{
-				CalcPositionRec(originalStateVec, newStateVec, currObj + 1, action, buffer);
+				mapped = other;
 			}
 		}
-		// if the object is enemy add cases of when the enemy is dead
-		if (currObj == 1)
-		{
-			originalStateVec[currObj] = DEAD_ENEMY;
-			newStateVec[currObj] = DEAD_ENEMY;
-			CalcPositionRec(originalStateVec, newStateVec, currObj + 1, action, buffer);
-		}
+		actionMap.push_back(mapped);
 	}
 }
 
-void POMDP_Writer::PositionSingleState(state_t & stateVec, std::string & currentState, std::string & action, std::string & buffer)
+void POMDP_Writer::CalcPositionSelf(int self, int newSelf, int action, ChunkBuffer& buffer, Context& ctx)
 {
-	std::string prefix = "T: " + action + " : " + currentState + " : ";
-	// if robot position is in the target go to win state
-	if (stateVec[0] == s_idxTarget)
+	state_t stateVec(2 + m_NInvVector.size());
+
+	// run on all states with live enemy and then on all states with dead enemy of the current robot location
+	size_t first = m_indexer.FirstLive(self);
+	for (size_t idx = first; idx < first + m_indexer.LiveBlock(); ++idx)
 	{
-		buffer += prefix + s_WinState + " " + std::to_string(s_pLeftProbability) + "\n";
-		return;
+		CalcPositionSingleIdx(idx, newSelf, stateVec, action, buffer, ctx);
 	}
-	prefix += "s";
-
-	// calculate possible move states from current location
-	int *moveStates = new int[5 * (1 + m_NInvVector.size())];
-	CalcMoveStates(stateVec, moveStates);
 
-	// array of idx pointing to the current move state
-	size_t *arrOfIdx = new size_t[1 + m_NInvVector.size()];
-	for (size_t i = 0; i < 1 + m_NInvVector.size(); ++i)
+	first = m_indexer.FirstDead(self);
+	for (size_t idx = first; idx < first + m_indexer.DeadBlock(); ++idx)
 	{
-		arrOfIdx[i] = i * 5;
+		CalcPositionSingleIdx(idx, newSelf, stateVec, action, buffer, ctx);
 	}
-
-	mapProb pMap;
-	// calculate the probability of each move state and insert it to pMap
-	AddMoveStatesRec(stateVec, moveStates, arrOfIdx, 0, pMap);
-	// erase the junk state from the pMap
-	pMap.erase(s_junkState);
-	// insert the move states to the buffer
-	size_t numStates = m_gridSize * m_gridSize;
-	std::for_each(pMap.begin(), pMap.end(), [&buffer, &prefix, numStates](pairMap itr)
-	{	buffer += prefix;	POMDP_Writer::AddStateToBuffer(buffer, itr, numStates); });
-
-	delete[] moveStates;
-	delete[] arrOfIdx;
 }
 
-void POMDP_Writer::AddStateToBuffer(std::string& buffer, pairMap itr, size_t numStates)
+void POMDP_Writer::CalcPositionSingleIdx(size_t stateIdx, int newSelf, state_t & stateVec, int action, ChunkBuffer& buffer, Context& ctx)
 {
-	buffer += std::to_string(itr.first[0]);
-	size_t start = 1;
-
-	// if the enemy dead add his state
-	if (itr.first[ENEMY_IDX] == DEAD_ENEMY)
+	if (!IsOutput(stateIdx, "s"))
 	{
-		buffer += "xD";
-		++start;
+		return;
 	}
-	for (size_t i = start; i < itr.first.size(); ++i)
+
+	++ctx.m_counters.m_states;
+	++ctx.m_counters.m_rows;
+	m_indexer.Unrank(stateIdx, &stateVec[0]);
+	if (InEnemyRange(stateVec))
 	{
-		buffer += "x" + std::to_string(itr.first[i]);
+		AddTransitionToBuffer(buffer, ctx, action, stateIdx, m_indexer.LossIdx(), m_enemy.GetPHit());
+		ctx.m_pLeftProbability = 1 - m_enemy.GetPHit();
 	}
-	buffer += " " + std::to_string(itr.second) + "\n";
-}
-
-size_t POMDP_Writer::CountEdges(int state, size_t gridSize)
-{
-	size_t x = state % gridSize;
-	size_t y = state / gridSize;
 
-	return (x == 0) + (x == gridSize - 1) + (y == 0) + (y == gridSize - 1);
+	// calculate the end-state from the state with the new location of the robot
+	stateVec[0] = newSelf;
+	PositionSingleState(stateVec, stateIdx, action, buffer, ctx);
+	if (nullptr == ctx.m_model)
+	{
+		buffer += "\n";
+	}
+	ctx.m_pLeftProbability = 1;
 }
 
-bool POMDP_Writer::InEnemyRange(state_t & stateVec)
+void POMDP_Writer::PositionSingleState(state_t & stateVec, size_t currentIdx, int action, ChunkBuffer& buffer, Context& ctx)
 {
-	if (stateVec[ENEMY_IDX] == DEAD_ENEMY)
+	// if robot position is in the target go to win state
+	if (static_cast<size_t>(stateVec[0]) == m_idxTarget)
 	{
-		return false;
+		AddTransitionToBuffer(buffer, ctx, action, currentIdx, m_indexer.WinIdx(), ctx.m_pLeftProbability);
+		return;
 	}
 
-	int xSelf = stateVec[0] % m_gridSize;
-	int ySelf = stateVec[0] / m_gridSize;
-	int xEnemy = stateVec[1] % m_gridSize;
-	int yEnemy = stateVec[1] / m_gridSize;
-
-	if (xEnemy == xSelf)
+	// the objects are in their previous locations in stateVec (only the robot moved)
+	const int *origins = &stateVec[1];
+	int selfOrigin = m_indexer.GetSelf(currentIdx);
+	size_t numObjects = stateVec.size() - 1;
+	size_t movesIdx = MovesIdx(stateVec);
+	state_t& moveState = ctx.m_moveState;
+	moveState = stateVec;
+
+	ProbabilityAccumulator& pMap = ctx.m_pMap;
+	pMap.Clear();
+	// insert each move of the objects with the robot in its new location to pMap (correct the repetitions with the robot and between the objects)
+	for (size_t move = m_movesOffset[movesIdx]; move < m_movesOffset[movesIdx + 1]; ++move)
+	{
+		double p = ctx.m_pLeftProbability;
+		moveState[0] = stateVec[0];
+		for (size_t i = 0; i < numObjects; ++i)
+		{
+			moveState[i + 1] = m_movesLocation[move * numObjects + i];
+			p *= m_movesProbability[move * numObjects + i];
+		}
+		NoRepetitionCheckAndCorrect(&moveState[0], moveState.size(), origins, selfOrigin);
+		pMap.Add(m_indexer.Rank(&moveState[0]), p);
+	}
+	// the order of the idx is the order of the states (all end-states of a row are live or all are dead)
+	pMap.Sort();
+	ctx.m_counters.m_mapInsertions += pMap.GetSize();
+	// insert the move states to the buffer (or to the model)
+	if (nullptr != ctx.m_model)
+	{
+		for (auto & itr : pMap)
+		{
+			ctx.m_model->AddTransition(action, currentIdx, itr.m_idx, itr.m_p);
+		}
+	}
+	else
 	{
-		int advanceFactor = m_gridSize - 2 * m_gridSize * (ySelf < yEnemy);
-		return InEnemyRangeIMP(stateVec, advanceFactor);
+		SetRowPrefix(ctx.m_prefix, "T", action, currentIdx);
+		for (auto & itr : pMap)
+		{
+			AddStateToBuffer(buffer, ctx, itr.m_idx, itr.m_p, "s");
+		}
 	}
-	else if (yEnemy == ySelf)
+}
+
+void POMDP_Writer::AddStateToBuffer(ChunkBuffer& buffer, Context& ctx, size_t stateIdx, double p, const char *type)
+{
+	// end-states that are not written have probability 0
+	if (!IsOutput(stateIdx, type))
 	{
-		int advanceFactor = 1 - 2 * (xSelf < xEnemy);
-		return InEnemyRangeIMP(stateVec, advanceFactor);
+		return;
 	}
 
-	return false;
+	++ctx.m_counters.m_lines;
+	buffer += ctx.m_prefix;
+	AppendState(buffer, stateIdx, type);
+	buffer += ' ';
+	buffer.AppendFixed(p, m_precision);
+	buffer += '\n';
 }
 
-bool POMDP_Writer::InEnemyRangeIMP(state_t & stateVec, int advanceFactor)
+void POMDP_Writer::AddTransitionToBuffer(ChunkBuffer& buffer, Context& ctx, int action, size_t stateIdx, size_t endIdx, double p)
 {
-	int shot = stateVec[1] + advanceFactor;
-	for (size_t i = 0; i < m_enemy.GetRange(); ++i)
+	if (nullptr != ctx.m_model)
 	{
-		if (SearchForShelter(shot))
-		{
-			break;
-		}
-		else if (stateVec[0] == shot)
-		{
-			return true;
-		}
-		shot += advanceFactor;
+		ctx.m_model->AddTransition(action, stateIdx, endIdx, p);
+		return;
 	}
 
-	return false;
+	SetRowPrefix(ctx.m_prefix, "T", action, stateIdx);
+	AddStateToBuffer(buffer, ctx, endIdx, p, "s");
 }
 
-std::string POMDP_Writer::GetCurrentState(state_t & stateVec)
+void POMDP_Writer::SetRowPrefix(std::string& prefix, const char *section, int action, size_t stateIdx) const
 {
-	std::string currentState = "s";
-	size_t i = 0;
-	for (; i < stateVec.size() - 1; ++i)
+	// the state is formatted on the stack so the prefix keeps its memory between rows
+	char state[32 * TextFormat::s_maxInteger + 8];
+	char *end = state;
+	if (m_isIndexed)
 	{
-		if (stateVec[i] != DEAD_ENEMY)
-		{
-			currentState += std::to_string(stateVec[i]) + "x";
-		}
-		else
-		{
-			currentState += "Dx";
-		}
+		end = TextFormat::Integer(state, state + sizeof(state), OutputIdx(stateIdx, "s"));
+	}
+	else
+	{
+		int stateVec[StateIndexer::s_maxObjects];
+		m_indexer.Unrank(stateIdx, stateVec);
+		end = TextFormat::StateName(state, state + sizeof(state), stateVec, m_indexer.GetNumObjects(), "s");
 	}
-	currentState += std::to_string(stateVec[i]);
 
-	return std::move(currentState);
+	prefix.assign(section);
+	prefix += ": ";
+	prefix += GetActionName(action);
+	prefix += " : ";
+	prefix.append(state, end);
+	prefix += " : ";
 }
 
+bool POMDP_Writer::InEnemyRange(const state_t & stateVec) const
+{
+	return stateVec[ENEMY_IDX] != DEAD_ENEMY && m_enemyFire->CanHit(stateVec[ENEMY_IDX], stateVec[0]);
+}
 
+std::string POMDP_Writer::StateName(size_t idx, const char *type) const
+{
+	char name[32 * TextFormat::s_maxInteger + 8];
+	int stateVec[StateIndexer::s_maxObjects];
+	m_indexer.Unrank(idx, stateVec);
+	return std::string(name, TextFormat::StateName(name, name + sizeof(name), stateVec, m_indexer.GetNumObjects(), type));
+}
 
-void POMDP_Writer::CalcHits(std::string & buffer)
+void POMDP_Writer::AppendStateName(ChunkBuffer& buffer, const int *stateVec, const char *type) const
 {
-	int *stateVec = new int[3 + m_NInvVector.size()];
-	state_t stateV(2 + m_NInvVector.size());
-	stateVec[2 + m_NInvVector.size()] = -1;
-	CalcHitsRec(stateV, 0, buffer);
+	size_t size = strlen(type) + m_indexer.GetNumObjects() * TextFormat::s_maxInteger;
+	char *first = buffer.Reserve(size);
+	buffer.Commit(TextFormat::StateName(first, first + size, stateVec, m_indexer.GetNumObjects(), type));
 }
 
-void POMDP_Writer::CalcHitsRec(state_t& stateVec, size_t currIdx, std::string & buffer)
+void POMDP_Writer::AppendState(ChunkBuffer& buffer, size_t stateIdx, const char *type) const
 {
-	if (stateVec.size() == currIdx)
+	if (stateIdx == m_indexer.WinIdx() || stateIdx == m_indexer.LossIdx())
+	{
+		buffer += stateIdx == m_indexer.WinIdx() ? m_winName : m_lossName;
+	}
+	else if (m_isIndexed)
 	{
-		CalcHitsSingleState(stateVec, buffer);
+		buffer.AppendInteger(OutputIdx(stateIdx, type));
 	}
 	else
 	{
-		for (size_t i = 0; i < m_gridSize * m_gridSize; ++i)
-		{
-			stateVec[currIdx] = i;
-			if (NoRepetition(stateVec, currIdx))
-			{
-				CalcHitsRec(stateVec, currIdx + 1, buffer);
-			}
-		}
+		int stateVec[StateIndexer::s_maxObjects];
+		m_indexer.Unrank(stateIdx, stateVec);
+		AppendStateName(buffer, stateVec, type);
 	}
 }
 
-void POMDP_Writer::CalcHitsSingleState(state_t& stateVec, std::string & buffer)
-{
-	std::string action = "Shoot_North";
-	CalcHitsSingleDirection(stateVec, -1 * m_gridSize, action, buffer);
 
-	action = "Shoot_South";
-	CalcHitsSingleDirection(stateVec, m_gridSize, action, buffer);
 
-	action = "Shoot_East";
-	CalcHitsSingleDirection(stateVec, 1, action, buffer);
 
-	action = "Shoot_West";
-	CalcHitsSingleDirection(stateVec, -1, action, buffer);
+void POMDP_Writer::CalcHits(ChunkBuffer& buffer)
+{
+	// run on all robot locations (in parallel when there is a pool)
+	RunShards(m_gridSize * m_gridSize, [this](size_t shard, ChunkBuffer& shardBuffer, Context& ctx)
+	{
+		CalcHitsSelf(shard, shardBuffer, ctx);
+	}, buffer);
 }
 
-void POMDP_Writer::CalcHitsSingleDirection(state_t & stateVec, int advanceFactor, std::string & action, std::string & buffer)
+void POMDP_Writer::CalcHitsSelf(int self, ChunkBuffer& buffer, Context& ctx)
 {
-	int target = stateVec[0];
-	std::string prefix = "T: " + action + " : " + GetCurrentState(stateVec) + " : ";
+	// shooting is possible only when the enemy is alive
+	size_t first = m_indexer.FirstLive(self);
+	for (size_t idx = first; idx < first + m_indexer.LiveBlock(); ++idx)
+	{
+		CalcHitsSingleState(idx, buffer, ctx);
+	}
+}
 
-	// run on track of the shot to see what it hit
-	for (size_t i = 0; i < m_self.GetRange() && InBoundary(target, advanceFactor, m_gridSize); ++i)
+void POMDP_Writer::CalcHitsSingleState(size_t stateIdx, ChunkBuffer& buffer, Context& ctx)
+{
+	if (!IsOutput(stateIdx, "s"))
 	{
-		target += advanceFactor;
+		return;
+	}
 
-		// if the shot hit shelter do nothing
-		if (SearchForShelter(target))
-		{
-			return;
-		}
+	++ctx.m_counters.m_states;
+	state_t stateVec(2 + m_NInvVector.size());
+	m_indexer.Unrank(stateIdx, &stateVec[0]);
+
+	CalcHitsSingleDirection(stateVec, stateIdx, DIR_NORTH, ActionIdx("Shoot_North"), buffer, ctx);
+	CalcHitsSingleDirection(stateVec, stateIdx, DIR_SOUTH, ActionIdx("Shoot_South"), buffer, ctx);
+	CalcHitsSingleDirection(stateVec, stateIdx, DIR_EAST, ActionIdx("Shoot_East"), buffer, ctx);
+	CalcHitsSingleDirection(stateVec, stateIdx, DIR_WEST, ActionIdx("Shoot_West"), buffer, ctx);
+}
+
+void POMDP_Writer::CalcHitsSingleDirection(state_t & stateVec, size_t stateIdx, GridDirection direction, int action, ChunkBuffer& buffer, Context& ctx)
+{
+	// run on track of the shot to see what it hit (the track ends before a shelter)
+	const int *end = m_selfFire->RayEnd(stateVec[0], direction);
+	for (const int *shot = m_selfFire->RayBegin(stateVec[0], direction); shot != end; ++shot)
+	{
+		int target = *shot;
 
 		// if the shot hit non-involved the calculate the chance for loss and the rest treat them as moving state
 		for (size_t i = 0; i < m_NInvVector.size(); ++i)
 		{
 			if (stateVec[i + 2] == target)
 			{
-				CalcHitNInv(stateVec, action, prefix, buffer);
+				CalcHitNInv(stateVec, stateIdx, action, buffer, ctx);
 				return;
 			}
 		}
@@ -703,40 +1534,43 @@ void POMDP_Writer::CalcHitsSingleDirection(state_t & stateVec, int advanceFactor
 		// if the shot hits the target calculate the chance that the enemy is dead
 		if (stateVec[1] == target)
 		{
-			CalcHitEnemy(stateVec, action, prefix, buffer);
+			CalcHitEnemy(stateVec, stateIdx, action, buffer, ctx);
 			return;
 		}
 	}
 }
 
-void POMDP_Writer::CalcHitEnemy(state_t & stateVec, std::string & action, std::string & prefix, std::string & buffer)
+void POMDP_Writer::CalcHitEnemy(state_t & stateVec, size_t stateIdx, int action, ChunkBuffer& buffer, Context& ctx)
 {
 	// if we are in enemy range calculate first the chance for enemy hit (if both enemy and robot hit we are at loss state)
 	if (InEnemyRange(stateVec))
 	{
-		buffer += "T: " + action + " : " + GetCurrentState(stateVec) + " : " + s_LossState + " " + std::to_string(m_enemy.GetPHit()) + "\n";
-		s_pLeftProbability *= 1 - m_enemy.GetPHit();
+		AddTransitionToBuffer(buffer, ctx, action, stateIdx, m_indexer.LossIdx(), m_enemy.GetPHit());
+		ctx.m_pLeftProbability *= 1 - m_enemy.GetPHit();
 	}
 
 	// calculate states with a dead enemy and a live robot
-	s_pLeftProbability *= m_self.GetPHit();
+	ctx.m_pLeftProbability *= m_self.GetPHit();
 	int tmp = stateVec[1];
-	std::string currentState = GetCurrentState(stateVec);
 	stateVec[1] = DEAD_ENEMY;
-	PositionSingleState(stateVec, currentState, action, buffer);
+	PositionSingleState(stateVec, stateIdx, action, buffer, ctx);
 	// return states and prob to normal
 	stateVec[1] = tmp;
-	s_pLeftProbability /= m_self.GetPHit();
+	ctx.m_pLeftProbability /= m_self.GetPHit();
 
 	// calculate states with a miss
-	s_pLeftProbability *= 1 - m_self.GetPHit();
-	PositionSingleState(stateVec, GetCurrentState(stateVec), action, buffer);
+	ctx.m_pLeftProbability *= 1 - m_self.GetPHit();
+	PositionSingleState(stateVec, stateIdx, action, buffer, ctx);
 
-	s_pLeftProbability = 1;
-	buffer += "\n";
+	++ctx.m_counters.m_rows;
+	ctx.m_pLeftProbability = 1;
+	if (nullptr == ctx.m_model)
+	{
+		buffer += "\n";
+	}
 }
 
-void POMDP_Writer::CalcHitNInv(state_t & stateVec, std::string & action, std::string & prefix, std::string & buffer)
+void POMDP_Writer::CalcHitNInv(state_t & stateVec, size_t stateIdx, int action, ChunkBuffer& buffer, Context& ctx)
 {
 	// if we are in enemy range calculate first the chance for enemy hit (if both enemy and robot hit we are at loss state)
 	double pToLoss = 0.0;
@@ -747,97 +1581,107 @@ void POMDP_Writer::CalcHitNInv(state_t & stateVec, std::string & action, std::st
 
 	// calculate p(robot dead | kill n-inv)
 	pToLoss = pToLoss + m_self.GetPHit() - pToLoss * m_self.GetPHit();
-	buffer += prefix + s_LossState + " " + std::to_string(pToLoss) + "\n";
+	AddTransitionToBuffer(buffer, ctx, action, stateIdx, m_indexer.LossIdx(), pToLoss);
 	// calculate states with a miss
-	s_pLeftProbability = 1 - pToLoss;
-	PositionSingleState(stateVec, GetCurrentState(stateVec), action, buffer);
+	ctx.m_pLeftProbability = 1 - pToLoss;
+	PositionSingleState(stateVec, stateIdx, action, buffer, ctx);
 
-	s_pLeftProbability = 1;
-	buffer += "\n";
+	++ctx.m_counters.m_rows;
+	ctx.m_pLeftProbability = 1;
+	if (nullptr == ctx.m_model)
+	{
+		buffer += "\n";
+	}
 }
 
-
-bool POMDP_Writer::SearchForShelter(int location)
+void POMDP_Writer::CalcObjectsMoves()
 {
-	for (auto v : m_shelter)
+	// the moves are calculated once for each save
+	if (!m_movesOffset.empty())
 	{
-		if (v.GetLocation().GetIdx(m_gridSize) == location)
-		{
-			return true;
-		}
+		return;
 	}
-	return false;
-}
 
-bool POMDP_Writer::InBoundary(int state, int advanceFactor, int gridSize)
-{
-	int x = state % gridSize;
-	int y = state / gridSize;
-	int xdiff = advanceFactor % gridSize;
-	int ydiff = advanceFactor / gridSize;
+	size_t numObjects = m_indexer.GetNumObjects() - 1;
+	size_t numStates = m_indexer.NumLive() + m_indexer.NumDead();
+	state_t stateVec(m_indexer.GetNumObjects());
+	std::vector<int> moveStates(5 * numObjects);
+	std::vector<size_t> arrOfIdx(numObjects);
 
-return ((x + xdiff) >= 0) & ((x + xdiff) < gridSize) & ((y + ydiff) >= 0) & ((y + ydiff) < gridSize);
-}
+	m_movesOffset.assign(numStates + 1, 0);
+	m_movesLocation.clear();
+	m_movesProbability.clear();
 
-void POMDP_Writer::AddMoveStatesRec(state_t & stateVec, int * moveStates, size_t * arrOfIdx, size_t currIdx, mapProb & pMap)
-{
-	if (currIdx == stateVec.size() - 1)
+	// each configuration is calculated once: in the state with the robot in the first free location
+	for (size_t idx = 0; idx < numStates; ++idx)
 	{
-		pMap[MoveToIdx(stateVec, moveStates, arrOfIdx)] += CalcProb2Move(stateVec, moveStates, arrOfIdx);
+		m_movesOffset[idx] = m_movesProbability.size() / numObjects;
+		m_indexer.Unrank(idx, &stateVec[0]);
+		if (MovesIdx(stateVec) != idx)
+		{
+			continue;
+		}
+
+		// calculate possible move states from current location (arrOfIdx points to the current move state of each object)
+		CalcMoveStates(stateVec, &moveStates[0]);
+		for (size_t i = 0; i < numObjects; ++i)
+		{
+			arrOfIdx[i] = i * 5;
+		}
+		AddObjectsMovesRec(stateVec, &moveStates[0], &arrOfIdx[0], 0);
 	}
-	else
+	m_movesOffset[numStates] = m_movesProbability.size() / numObjects;
+}
+
+void POMDP_Writer::AddObjectsMovesRec(state_t & stateVec, int * moveStates, size_t * arrOfIdx, size_t currIdx)
+{
+	if (currIdx < stateVec.size() - 1)
 	{
 		size_t remember = arrOfIdx[currIdx];
 		for (size_t i = 0; i < 5; ++i, ++arrOfIdx[currIdx])
 		{
-			AddMoveStatesRec(stateVec, moveStates, arrOfIdx, currIdx + 1, pMap);
+			AddObjectsMovesRec(stateVec, moveStates, arrOfIdx, currIdx + 1);
 		}
 
 		arrOfIdx[currIdx] = remember;
+		return;
 	}
-}
 
+	// a dead enemy doesn't move
+	if (moveStates[0] == DEAD_ENEMY && arrOfIdx[0] != 0)
+	{
+		return;
+	}
 
-POMDP_Writer::state_t POMDP_Writer::MoveToIdx(state_t stateVec, int * moveStates, size_t * arrOfIdx)
-{
-	// insert the current move state to the state vec
+	// insert the current move state of each object (an object that can't move stays in its location) and the probability of its move
 	for (size_t i = 0; i < stateVec.size() - 1; ++i)
 	{
 		int currState = moveStates[arrOfIdx[i]];
-		if (currState == NVALID_MOVE && moveStates[i * 5] == DEAD_ENEMY)
-		{
-			return s_junkState;
-		}
+		m_movesLocation.push_back(currState * (-1 != currState) + moveStates[i * 5] * (NVALID_MOVE == currState));
 
-		stateVec[i + 1] = currState * (-1 != currState) + moveStates[i * 5] * (NVALID_MOVE == currState);
+		const Move_Properties& movement = 0 == i ? m_enemy.GetMovement() : m_NInvVector[i - 1].GetMovement();
+		bool isStay = arrOfIdx[i] % 5 == 0;
+		m_movesProbability.push_back(moveStates[i * 5] == DEAD_ENEMY ? 1.0 : movement.GetStay() * isStay + movement.GetEqual() * !isStay);
 	}
-
-	// correct the state vec in case of repetitions
-	NoRepetitionCheckAndCorrect(stateVec, moveStates, arrOfIdx);
-
-	return stateVec;
 }
 
-double POMDP_Writer::CalcProb2Move(state_t & stateVec, int * moveStates, size_t * arrOfIdx)
+size_t POMDP_Writer::MovesIdx(const state_t& stateVec) const
 {
-	// insert to p the whole (replacement of 1 due to cases that reduce probability)
-	double pMoveState = s_pLeftProbability;
+	int config[StateIndexer::s_maxObjects];
+	std::copy(stateVec.begin(), stateVec.end(), config);
 
-	// multiply with the p(enemy = moveState) if the enemy is not dead
-	if (stateVec[ENEMY_IDX] != DEAD_ENEMY)
-	{
-		pMoveState *= m_enemy.GetMovement().GetStay() * (arrOfIdx[0] == 0) +
-			m_enemy.GetMovement().GetEqual() * (arrOfIdx[0] != 0);
-	}
-	
-	// multiply with the p(non-involved = moveState)
-	for (size_t i = 0; i < m_NInvVector.size(); ++i)
+	// find the first location that is not taken by the objects
+	config[0] = 0;
+	for (size_t i = 1; i < stateVec.size(); ++i)
 	{
-		pMoveState *= m_NInvVector[i].GetMovement().GetStay() * (arrOfIdx[i + 1] % 5 == 0) +
-			m_NInvVector[i].GetMovement().GetEqual() * (arrOfIdx[i + 1] % 5 != 0);
+		if (config[i] == config[0])
+		{
+			++config[0];
+			i = 0;
+		}
 	}
 
-	return pMoveState;
+	return m_indexer.Rank(config);
 }
 
 void POMDP_Writer::CalcMoveStates(state_t & stateVec, int * moveStates)
@@ -854,65 +1698,59 @@ void POMDP_Writer::CalcMoveStates(state_t & stateVec, int * moveStates)
 		}
 	}
 
-	// calculate possible move state (for non-valid move state insert -1 in movestates array)
+	// the possible move states are the neighbors of the object (for non-valid move state the neighbor is NVALID_MOVE)
 	for (size_t i = start; i < stateVec.size() - 1; ++i)
 	{
-		int x = stateVec[i + 1] % m_gridSize;
-		int y = stateVec[i + 1] / m_gridSize;
-		moveStates[5 * i] = x + y * m_gridSize;
-		moveStates[5 * i + 1] = ((x + 1) + (y * m_gridSize)) * (x + 1 < m_gridSize) + NVALID_MOVE * (x + 1 == m_gridSize);
-		moveStates[5 * i + 2] = ((x - 1) + (y * m_gridSize)) * (x - 1 >= 0) + NVALID_MOVE * (x - 1 < 0);
-		moveStates[5 * i + 3] = ((x)+((y + 1) * m_gridSize)) * (y + 1 < m_gridSize) + NVALID_MOVE * (y + 1 == m_gridSize);
-		moveStates[5 * i + 4] = ((x)+((y - 1) * m_gridSize)) * (y - 1 >= 0) + NVALID_MOVE * (y - 1 < 0);
+		const int *neighbors = m_topology->GetNeighbors(stateVec[i + 1]);
+		std::copy(neighbors, neighbors + NUM_DIRECTIONS, moveStates + 5 * i);
 	}
 }
 
-void POMDP_Writer::CalcObs(std::string& buffer)
+void POMDP_Writer::CalcObs(ChunkBuffer& buffer)
 {
-	state_t stateVec(2 + m_NInvVector.size());
-	CalcObsRec(stateVec, 0, buffer);
+	// run on all robot locations (in parallel when there is a pool)
+	RunShards(m_gridSize * m_gridSize, [this](size_t shard, ChunkBuffer& shardBuffer, Context& ctx)
+	{
+		CalcObsSelf(shard, shardBuffer, ctx);
+	}, buffer);
 }
-void POMDP_Writer::CalcObsRec(std::vector<int>& stateVec, size_t currIdx, std::string & buffer)
+
+void POMDP_Writer::CalcObsSelf(int self, ChunkBuffer& buffer, Context& ctx)
 {
-	if (currIdx == stateVec.size())
+	// calculate observations of states with live enemy and then with dead enemy
+	size_t first = m_indexer.FirstLive(self);
+	for (size_t idx = first; idx < first + m_indexer.LiveBlock(); ++idx)
 	{
-		// arriving here when stateVec is initialize to a state. run on this state calculation of observations
-		CalcObsSingleState(stateVec, buffer);
-		buffer += "\n";
+		CalcObsSingleState(idx, buffer, ctx);
 	}
-	else
-	{
-		// run on all possible locations. if there location is valid call for the calculation of the next object
-		for (size_t i = 0; i < m_gridSize*m_gridSize; ++i)
-		{
-			stateVec[currIdx] = i;
-			if (NoRepetition(stateVec, currIdx))
-			{
-				CalcObsRec(stateVec, currIdx + 1, buffer);
-			}
-		}
 
-		if (currIdx == ENEMY_IDX)
-		{
-			stateVec[currIdx] = DEAD_ENEMY;
-			CalcObsRec(stateVec, currIdx + 1, buffer);
-		}
+	first = m_indexer.FirstDead(self);
+	for (size_t idx = first; idx < first + m_indexer.DeadBlock(); ++idx)
+	{
+		CalcObsSingleState(idx, buffer, ctx);
 	}
-
 }
 
-void POMDP_Writer::CalcObsSingleState(state_t& stateVec, std::string& buffer)
+void POMDP_Writer::CalcObsSingleState(size_t stateIdx, ChunkBuffer& buffer, Context& ctx)
 {
-	std::string prefix = "O: * : " + GetCurrentState(stateVec) + " : o";
+	if (!IsOutput(stateIdx, "s"))
+	{
+		return;
+	}
+
+	state_t stateVec(2 + m_NInvVector.size());
+	m_indexer.Unrank(stateIdx, &stateVec[0]);
+
 	std::vector<bool> inRange(stateVec.size());
 	state_t newState(stateVec);
-	mapProb pMap;
+	ProbabilityAccumulator& pMap = ctx.m_pMap;
+	pMap.Clear();
 
 	// create a vector indicating which one of the different object is in range
 	//if (InObsRange(stateVec[0], stateVec[1], m_gridSize, m_self.GetRange()) || )
 	for (size_t i = 1; i < stateVec.size(); ++i)
 	{
-		if (InObsRange(stateVec[0], stateVec[i], m_gridSize, m_self.GetRange()))
+		if (InObsRange(stateVec[0], stateVec[i]))
 		{
 			inRange[i] = true;
 		}
@@ -923,23 +1761,67 @@ void POMDP_Writer::CalcObsSingleState(state_t& stateVec, std::string& buffer)
 	}
 
 	CalcObsMapRec(newState, stateVec, pMap, inRange, 1.0, 1);
-	size_t numStates = m_gridSize * m_gridSize;
-	std::for_each(pMap.begin(), pMap.end(), [&buffer, &prefix, numStates](pairMap itr)
-	{	buffer += prefix;	POMDP_Writer::AddStateToBuffer(buffer, itr, numStates); });
+	pMap.Sort();
+	++ctx.m_counters.m_states;
+	++ctx.m_counters.m_rows;
+	ctx.m_counters.m_mapInsertions += pMap.GetSize();
+	if (nullptr != ctx.m_model)
+	{
+		for (auto & itr : pMap)
+		{
+			if (IsOutput(itr.m_idx, "o"))
+			{
+				ctx.m_model->AddObservation(stateIdx, OutputIdx(itr.m_idx, "o"), itr.m_p);
+			}
+		}
+		return;
+	}
+
+	SetRowPrefix(ctx.m_prefix, "O", ALL_ACTIONS, stateIdx);
+	for (auto & itr : pMap)
+	{
+		AddStateToBuffer(buffer, ctx, itr.m_idx, itr.m_p, "o");
+	}
+	buffer += "\n";
+}
+
+void POMDP_Writer::CalcObsFactors(size_t stateIdx, BinaryObservationFactor *factors)
+{
+	state_t stateVec(m_indexer.GetNumObjects());
+	m_indexer.Unrank(stateIdx, &stateVec[0]);
+
+	// the same distribution as CalcObsMapRec: an object in range is observed in its location with pObs
+	// (when no previous object was observed there) and the rest is divided uniformly between the free locations
+	for (size_t i = 1; i < stateVec.size(); ++i)
+	{
+		bool inRange = InObsRange(stateVec[0], stateVec[i]);
+		factors[i - 1].m_location = stateVec[i];
+		if (stateVec[i] == DEAD_ENEMY)
+		{
+			// dead enemy "in range" keeps only the probability of the diverged observation (it overwrites the observed one in pMap)
+			factors[i - 1].m_kind = OBS_DEAD;
+			factors[i - 1].m_p = inRange ? 1 - m_self.GetPObs() : 1.0;
+		}
+		else
+		{
+			factors[i - 1].m_kind = inRange ? OBS_EXACT : OBS_UNIFORM;
+			factors[i - 1].m_p = inRange ? m_self.GetPObs() : 0.0;
+		}
+	}
 }
 
-void POMDP_Writer::CalcObsMapRec(state_t& stateVec, state_t& originalState, mapProb& pMap, std::vector<bool>& inRange, double pCurr, size_t currIdx)
+void POMDP_Writer::CalcObsMapRec(state_t& stateVec, state_t& originalState, ProbabilityAccumulator& pMap, std::vector<bool>& inRange, double pCurr, size_t currIdx)
 {
 	// stopping condition: arriving to the end of the state vec
 	if (currIdx == stateVec.size())
 	{
 		// insert p to map
-		pMap[stateVec] = pCurr;
+		pMap.Set(m_indexer.Rank(&stateVec[0]), pCurr);
 	}
 	else
 	{
 		// if the original location is in range & the current location is the original location and there are no repetition the location is observable
-		if (inRange[currIdx] & stateVec[currIdx] == originalState[currIdx] & NoRepetition(stateVec, currIdx))
+		if (inRange[currIdx] & (stateVec[currIdx] == originalState[currIdx]) & NoRepetition(stateVec, currIdx))
 		{
 			CalcObsMapRec(stateVec, originalState, pMap, inRange, pCurr * m_self.GetPObs(), currIdx + 1);
 			DivergeObs(stateVec, originalState, pMap, inRange, pCurr * (1 - m_self.GetPObs()), currIdx, true);
@@ -952,7 +1834,7 @@ void POMDP_Writer::CalcObsMapRec(state_t& stateVec, state_t& originalState, mapP
 
 }
 
-void POMDP_Writer::DivergeObs(state_t& stateVec, state_t& originalState, mapProb& pMap, std::vector<bool>& inRange, double pCurr, size_t currIdx, bool avoidCurrLoc)
+void POMDP_Writer::DivergeObs(state_t& stateVec, state_t& originalState, ProbabilityAccumulator& pMap, std::vector<bool>& inRange, double pCurr, size_t currIdx, bool avoidCurrLoc)
 {
 	// if the enemy is dead do not run on other options(because they are not possible)
 	if (stateVec[currIdx] == DEAD_ENEMY)
@@ -970,7 +1852,7 @@ void POMDP_Writer::DivergeObs(state_t& stateVec, state_t& originalState, mapProb
 		stateVec[currIdx] = i;
 
 		// if idx is curr location and is in range or if idx is repeated in previous locations do not call recursive function
-		if ( !(avoidCurrLoc && i == currLocation) && NoRepetition(stateVec, currIdx))
+		if ( !(avoidCurrLoc && i == static_cast<size_t>(currLocation)) && NoRepetition(stateVec, currIdx))
 		{
 			CalcObsMapRec(stateVec, originalState, pMap, inRange, pCurr / pDivision, currIdx + 1);
 		}	
@@ -979,18 +1861,18 @@ void POMDP_Writer::DivergeObs(state_t& stateVec, state_t& originalState, mapProb
 	stateVec[currIdx] = currLocation;
 }
 
-bool POMDP_Writer::InObsRange(int self, int object, size_t gridSize, size_t range)
+bool POMDP_Writer::InObsRange(int self, int object) const
 {
-	int xSelf = self % gridSize;
-	int ySelf = self / gridSize;
-	int xObj = object % gridSize;
-	int yObj = object / gridSize;
-
-	if (Abs(xSelf - xObj) <= range && Abs(ySelf - yObj) <= range)
+	if (object != DEAD_ENEMY)
 	{
-		return true;
+		return m_topology->Distance(self, object) <= m_self.GetRange();
 	}
-	return false;
+
+	// the location of a dead enemy is converted to size_t when its coordinates are calculated (keep the same result)
+	size_t range = m_self.GetRange();
+	int xObj = static_cast<size_t>(object) % m_gridSize;
+	int yObj = static_cast<size_t>(object) / m_gridSize;
+	return static_cast<size_t>(Abs(m_topology->GetX(self) - xObj)) <= range && static_cast<size_t>(Abs(m_topology->GetY(self) - yObj)) <= range;
 }
 
 size_t POMDP_Writer::NextInLine(std::vector<bool>& inRange, size_t currIdx)
@@ -7,6 +7,9 @@
 //	1-	objects can be in the same idx in the grid
 //	2-	if the enemy and the non-involved in the same idx shooting toward them will be considered as a loss
 //	3-	shooting action is a timeless action and no transition and moving can accure while shooting
+//	4-	an object that moves to a taken location returns to its previous location, and the robot stays in its location when it
+//		moves to an object that stays. the corrections are repeated until no two objects are in the same location
+//		(see NoRepetitionCheckAndCorrect), so every end-state is a state of the states line
 
 // COMMENTS REGARDING IMPLEMENTATION:
 //	1-	so far the charging of the enemy toward the target is not implemented
@@ -15,12 +18,31 @@
 
 #include <vector>
 #include <memory>
-#include <map>
+#include <functional>
+#include <chrono>
 
 #include "Self_Obj.h"
 #include "Attack_Obj.h"
 #include "Movable_Obj.h"
 #include "ObjInGrid.h"
+#include "StateIndexer.h"
+#include "OutputSink.h"
+#include "ChunkBuffer.h"
+#include "ThreadPool.h"
+#include "SparseModelBuilder.h"
+#include "BinaryModelFormat.h"
+#include "ProbabilityAccumulator.h"
+#include "GridTopology.h"
+#include "LineOfFire.h"
+#include "StartDistribution.h"
+#include "GridSymmetry.h"
+#include "Reachability.h"
+#include "SectionCache.h"
+#include "GridTables.h"
+#include "GenerationStats.h"
+#include "ModelEstimate.h"
+#include "PomdpModel.h"
+#include "BeliefFilter.h"
 
 class POMDP_Writer
 {
@@ -31,115 +53,306 @@ public:
 	void AddObj(Movable_Obj& obj);
 	void AddObj(ObjInGrid& obj);
 
-	void SaveInFormat(FILE *fptr, size_t idxTarget);
+	// write states, actions and observations as idx instead of names (states: N, observations: N).
+	// if namesSink is given the name of each idx is written to it when saving
+	void SetIndexedOutput(bool isIndexed, OutputSink *namesSink = nullptr);
+
+	// digits after the point of the probabilities in the text (default 6) or TextFormat::s_shortest for the shortest
+	// text that reads back to the same double. the start probabilities have 10 significant digits unless shortest
+	void SetPrecision(int precision);
+
+	// start probabilities below epsilon are dropped and the rest are normalized (default 0: nothing is dropped)
+	void SetStartEpsilon(double epsilon);
+	// write the start as its states ("start: <state>" or "start include: <states>") when it is uniform on its states.
+	// otherwise (and by default) the start is written as the probability of every state
+	void SetSparseStart(bool isSparse);
+
+	// calculate the transitions only for one robot location of each orbit of the symmetries of the grid that keep the target
+	// and the shelters, and permute them to the rest of the orbit. only for the transitions as matrices: SaveBinary, BuildModel
+	// and the transitions of the pruning (SetReachablePruning). the text of SaveInFormat is always calculated directly so the
+	// flag doesn't change the text, and without pruning it doesn't change the time of SaveInFormat
+	void SetSymmetryReduction(bool isSymmetric);
+
+	// write only the states that can be reached from the start states by any action (and win and loss) with new idx in the
+	// same order, and only the observations with the robot location of a reachable state.
+	// the text calculates the transitions once more as matrices before writing (with the symmetries when SetSymmetryReduction).
+	// the binary model keeps all the observations
+	void SetReachablePruning(bool isPruned);
+
+	// reuse the sections of the text (header and start, moves, shots, observations and rewards) from the cache when their
+	// inputs were not changed and add the calculated sections to the cache (nullptr for no cache). the cache is not owned
+	void SetSectionCache(SectionCache *cache);
+
+	// take the topology and the shots from tables shared with other writers (nullptr for tables of this writer only).
+	// the tables are not owned
+	void SetGridTables(GridTables *tables);
+
+	// write the statistics of each SaveInFormat to the sink as json (nullptr for no report). the sink is not owned
+	void SetStatsReport(OutputSink *reportSink);
+
+	// estimate the numbers of states and observations, the lines, the bytes, the memory and the time of SaveInFormat
+	// with the objects and the settings of the writer without calculating the model (see ModelEstimate)
+	ModelEstimate EstimateModel(size_t idxTarget, size_t threads = 1) const;
+
+	// write the pomdp format to a file or to a sink. returns the statistics of the save (see GenerationStats, a failed write
+	// and objects that are not valid states (see StateIndexer::IsValid) are in m_error)
+	// with threads > 1 the transitions are calculated in parallel (the output is the same as with a single thread)
+	GenerationStats SaveInFormat(FILE *fptr, size_t idxTarget, size_t threads = 1);
+	GenerationStats SaveInFormat(OutputSink& sink, size_t idxTarget, size_t threads = 1);
+
+	// write the model as sparse matrices in the binary model layout (see BinaryModelFormat.h). returns the number of bytes written
+	// (0 on failure or when the objects are not valid states).
+	// the rows of an action replace the rows of all actions ("*") and repeated end-states of a row are summed
+	size_t SaveBinary(FILE *fptr, size_t idxTarget, size_t threads = 1);
+	size_t SaveBinary(OutputSink& sink, size_t idxTarget, size_t threads = 1);
+
+	// filter of the belief over the states of the model for online tracking (the same dynamics as the model without its matrices).
+	// the states and the observations are the idx of StateIndexer (also when the model is pruned) and the belief starts at the start
+	// (empty when the objects are not valid states)
+	BeliefFilter CreateBeliefFilter(size_t idxTarget);
+
+	// return objects that moved to a taken location (and the robot when needed) to their previous location in the locations of a move
+	// (size locations, the robot first). origins is the previous location of each object except the robot
+	static void NoRepetitionCheckAndCorrect(int *stateVec, size_t size, const int *origins, int selfOrigin);
+
+	// calculate the model in memory for a solver in the same process (the model of the text of SaveInFormat with repeated end-states summed, see PomdpModel.h).
+	// T is float or double. with threads > 1 the transitions and the observations are calculated in parallel (an empty model
+	// when the objects are not valid states)
+	template <typename T>
+	PomdpModel<T> BuildModel(size_t idxTarget, size_t threads = 1);
 
 private:
 	size_t m_gridSize;
+	// neighbors and coordinates of the cells of the grid (may be shared with other writers)
+	std::shared_ptr<const GridTopology> m_topology;
 	
 	Self_Obj m_self;
 	Attack_Obj m_enemy;
 	std::vector<Movable_Obj> m_NInvVector;
 	std::vector<ObjInGrid> m_shelter;
 	double m_discount;
+	// dense idx of the states (initialized when saving)
+	StateIndexer m_indexer;
+	// idx for win state
+	size_t m_idxTarget;
+	// workers for parallel calculation (exist only while saving with more than 1 thread)
+	std::unique_ptr<ThreadPool> m_pool;
+	// output idx instead of names
+	bool m_isIndexed;
+	OutputSink *m_namesSink;
+	// name (or idx) of win and loss states in the output
+	std::string m_winName;
+	std::string m_lossName;
+	// precision of the probabilities in the text
+	int m_precision;
+	// start probabilities below the epsilon are dropped
+	double m_startEpsilon;
+	bool m_isSparseStart;
+	// calculate the model transitions with the symmetries of the grid
+	bool m_isSymmetric;
+	// write only the reachable states (m_reachable exists only while saving with pruning)
+	bool m_isPruned;
+	std::unique_ptr<Reachability> m_reachable;
+	// new idx of each observation (Reachability::s_unreachable for observation that is not written) and number of written observations
+	std::vector<uint32_t> m_observationIdx;
+	size_t m_numObservations;
+	// cache of the sections of the text (not owned)
+	SectionCache *m_sectionCache;
+	// tables shared between writers (not owned)
+	GridTables *m_gridTables;
+	// statistics of the current save, the counters of the current section and its start
+	GenerationStats m_stats;
+	GenerationStats::Counters m_counters;
+	std::chrono::steady_clock::time_point m_sectionStart;
+	size_t m_sectionBytes;
+	OutputSink *m_reportSink;
+	// name (or idx) of each action in the output (idx 0 is all actions "*")
+	std::vector<std::string> m_actionNames;
+	// the model entries are collected to the builder instead of writing text (exists only while saving binary)
+	SparseModelBuilder *m_model;
+
+	// cells of the shelters (initialized when saving)
+	std::vector<int> m_shelterCells;
+	// shots of the enemy and of the robot with the shelters of the scenario (initialized when saving, may be shared with other writers)
+	std::shared_ptr<const LineOfFire> m_enemyFire;
+	std::shared_ptr<const LineOfFire> m_selfFire;
+
+	// moves of the objects (except the robot) from each configuration of the objects, before correcting repetitions.
+	// the moves don't depend on the robot so they are calculated once (CalcObjectsMoves) for all robot locations and actions.
+	// the moves of a configuration are [m_movesOffset[c], m_movesOffset[c + 1]) where c is the idx of the configuration (see MovesIdx)
+	std::vector<size_t> m_movesOffset;
+	// location and probability of each object in each move (numObjects - 1 for each move)
+	std::vector<int> m_movesLocation;
+	std::vector<double> m_movesProbability;
 
 	using state_t = std::vector<int>;
-	using mapProb = std::map<state_t, double>;
-	using pairMap = std::pair<state_t, double>;
 
-	// to throw undesirable move to
-	static state_t s_junkState;
-
-	void CommentsAndInitLines(std::string buffer, FILE *fptr);
-	void PositionStates(std::string buffer, FILE *fptr);
-	void AttackAction(std::string buffer, FILE *fptr);
-	void ObservationsAndRewards(std::string buffer, FILE *fptr);
-
-	// Calculation of possible states
-	static void CalcStatesAndObs(size_t numObjects, size_t gridSize, std::string& type, std::string& buffer);
-	// recursion on all possible states or observations
-	static void CalcS_ORec(state_t& stateVec, size_t currIdx, size_t gridSize, std::string& type, std::string& buffer);
-
-	// divide the probability to init in a given state to all other states(in case the state is not possible)
-	static double DividePRepetitions(state_t& stateVec, double *pMat, int currIdx, size_t numStates);
-	// return the division from before to the revregular distribution
-	static void ReturnPRepetition(double *pMat, size_t numStates, double pRep);
+	// state of a single calculation task (each task has its own context so tasks can run in parallel)
+	struct Context
+	{
+		// to convey probability between calculations
+		double m_pLeftProbability = 1.0;
+		// probabilities of the end-states of a single row
+		ProbabilityAccumulator m_pMap;
+		// collect the entries of the task to the model instead of writing text (nullptr when writing text)
+		SparseModelBuilder *m_model = nullptr;
+		// scratch state for the moves of a single row
+		state_t m_moveState;
+		// text in the start of each line of the current row
+		std::string m_prefix;
+		// counters of the task (summed to the counters of the section when the task is merged)
+		GenerationStats::Counters m_counters;
+	};
+
+	// part of the transitions: all states with robot location self when the robot moves to newSelf
+	struct PositionShard
+	{
+		int m_self;
+		int m_newSelf;
+		int m_action;
+	};
+
+	using calcShard_t = std::function<void(size_t shard, ChunkBuffer& buffer, Context& ctx)>;
+	// calculate numShards shards to the buffer in the order of the shards (in parallel when there is a pool)
+	void RunShards(size_t numShards, const calcShard_t& calcShard, ChunkBuffer& buffer);
+
+	// sections of the text in the cache
+	enum TextSection
+	{
+		TEXT_HEADER = 0,
+		TEXT_POSITIONS = 1,
+		TEXT_HITS = 2,
+		TEXT_OBSERVATIONS = 3,
+	};
+
+	// initialize the indexer, the shots, the pool and the names for saving. returns false if the objects are not valid states
+	// (the error is in m_stats and nothing else is initialized)
+	bool InitSave(size_t idxTarget, size_t threads);
+	// write the section from the cache or calculate it with write (and add it to the cache)
+	void WriteSection(ChunkBuffer& buffer, TextSection section, void (POMDP_Writer::*write)(ChunkBuffer&));
+	// hash of the inputs of the section
+	uint64_t SectionKey(TextSection section);
+	// the statistics of the text written to buffer between BeginSection and EndSection are added to section
+	void BeginSection(ChunkBuffer& buffer);
+	void EndSection(GenerationStats::Section section, ChunkBuffer& buffer);
+	// calculate the transitions of each action as sparse matrices (the rows of an action replace the rows of all actions)
+	void CalcTransitionMatrices(std::vector<CsrMatrix>& transitions);
+	// calculate the observations of each state as a sparse matrix (the columns are the observations of the output)
+	CsrMatrix CalcObservationMatrix();
+	// find the reachable states and the observations to write
+	void CalcReachable(const std::vector<CsrMatrix>& transitions);
+	// idx of a state ("s") or observation ("o") in the output (Reachability::s_unreachable if it is not written)
+	size_t OutputIdx(size_t idx, const char *type) const;
+	bool IsOutput(size_t idx, const char *type) const { return Reachability::s_unreachable != OutputIdx(idx, type); }
+
+	// sections of the format. each section is streamed to the sink through the chunk buffer
+	void CommentsAndInitLines(ChunkBuffer& buffer);
+	void PositionStates(ChunkBuffer& buffer);
+	void AttackAction(ChunkBuffer& buffer);
+	void ObservationsAndRewards(ChunkBuffer& buffer);
+
+	// Calculation of possible states (run on all idx of live and dead states)
+	void CalcStatesAndObs(std::string& type, ChunkBuffer& buffer);
+	// write the names of all states, actions and observations with their idx. returns false if the names could not be written
+	bool WriteNames(OutputSink& sink);
+	// name of a state or an observation in the text (without idx)
+	std::string StateName(size_t idx, const char *type) const;
 
 	// Calculation of initial state:
-	void CalcStartState(std::string& buffer);
-	void CalcStartStateRec(double * pmat, state_t& stateVec, size_t currIdx, std::string& buffer);
+	void CalcStartState(ChunkBuffer& buffer);
+	// calculate the probability matrix of the location of each object (gridSize * gridSize for each object)
+	void CalcObjectsPosition(std::vector<double>& pMat);
+	// the non-zero probabilities of the live states at start
+	std::vector<StartDistribution::Entry> CalcStart();
 
 	static void CalcSinglePosition(ObjInGrid *obj, size_t gridSize, double *pMat);
+	// probability of each cell of a single axis: p[i] = cdf(i + 0.5) - cdf(i - 0.5) and the tails in the last cell
+	static void CalcAxisPosition(int mean, double std, size_t gridSize, double *p);
 	static void CalcSinglePositionNoStd(ObjInGrid *obj, size_t gridSize, double *pMat);
 	static double CumulativeDistFunc(double x, int mean, double std);
 
 	
+	// calculation of the transitions of all actions without attack
+	void CalcPositions(ChunkBuffer& buffer);
 	// Calculation of move possibility
-	void NoMovePosition(std::string& buffer);	// calculation move probabilities when the robot do not move
-	void MovePosition(std::string& buffer);		// calculation move probabilities when the robot move
+	void NoMovePosition(std::vector<PositionShard>& shards);	// calculation move probabilities when the robot do not move
+	void MovePosition(std::vector<PositionShard>& shards);		// calculation move probabilities when the robot move
 	// calculation of single direction move(i.e. north,east etc.)
-	void MovePositionSingleDirection(std::string& buffer, int advanceFactor, std::vector<int>::iterator toExclude, std::string& action);
+	void MovePositionSingleDirection(std::vector<PositionShard>& shards, GridDirection direction, int action);
+
+	// calculate the transitions of the model of one robot location in each orbit of the symmetries and permute them to the rest of the orbit
+	void CalcSymmetricTransitions(ChunkBuffer& buffer);
+	// idx of each state mapped by a symmetry of the grid (win and loss stay)
+	void CalcStateMap(const GridSymmetry& symmetry, size_t s, std::vector<uint32_t>& stateMap) const;
+	// action of each action (in idx action + 1) mapped by a symmetry of the grid
+	static void CalcActionMap(const GridSymmetry& symmetry, size_t s, std::vector<int>& actionMap);
 
-	// run on all possible states and calculate the end-state
-	void CalcPositionRec(state_t& originalStateVec, state_t& newStateVec, size_t currObj, std::string& action, std::string & buffer);
+	// run on all states with robot location self and calculate the end-state when the robot moves to newSelf
+	void CalcPositionSelf(int self, int newSelf, int action, ChunkBuffer& buffer, Context& ctx);
+	void CalcPositionSingleIdx(size_t stateIdx, int newSelf, state_t& stateVec, int action, ChunkBuffer& buffer, Context& ctx);
 
-	// calculate the end-state position from a single state(stateVec)
-	void PositionSingleState(state_t& stateVec, std::string& currentState, std::string& action, std::string& buffer);
+	// calculate the end-state position from a single state(stateVec) that its origin is the state currentIdx
+	void PositionSingleState(state_t& stateVec, size_t currentIdx, int action, ChunkBuffer& buffer, Context& ctx);
 
 	// calculate possible move states from a start-state
 	void CalcMoveStates(state_t & stateVec, int *moveStates);
-	// calculate the probability of the possible moveStates
-	void AddMoveStatesRec(state_t & stateVec, int *moveStates, size_t *arrOfIdx, size_t currIdx, mapProb& pMap);
-
-
-	// add state to buffer for the pomdp format
-	static void AddStateToBuffer(std::string& buffer, pairMap itr, size_t m_gridSize);
-	// count number of edges from a given location
-	static size_t CountEdges(int state, size_t gridSize);
+	// calculate the moves of the objects from all configurations of the objects
+	void CalcObjectsMoves();
+	// add the moves of the objects for each combination of moveStates (arrOfIdx points to the current move of each object)
+	void AddObjectsMovesRec(state_t & stateVec, int *moveStates, size_t *arrOfIdx, size_t currIdx);
+	// idx of the configuration of the objects (except the robot) in stateVec:
+	// the idx of the state with the same objects and the robot in the first location that is not taken by the objects
+	size_t MovesIdx(const state_t& stateVec) const;
+
+
+	// add line of the row of ctx with state (type is "s" for state or "o" for observation) and its probability to buffer for the pomdp format
+	void AddStateToBuffer(ChunkBuffer& buffer, Context& ctx, size_t stateIdx, double p, const char *type);
+	// add transition from stateIdx to endIdx to buffer (or to the model of the task)
+	void AddTransitionToBuffer(ChunkBuffer& buffer, Context& ctx, int action, size_t stateIdx, size_t endIdx, double p);
+	// set prefix to the start of the lines of a row ("<section>: <action> : <state> : ")
+	void SetRowPrefix(std::string& prefix, const char *section, int action, size_t stateIdx) const;
 	
-	// translate a state to the pomdp format
-	static std::string GetCurrentState(state_t& stateVec);
-
-	// returns the real end-state from a given moveState
-	state_t MoveToIdx(state_t stateVec, int *moveStates, size_t *arrOfIdx);
-	// calculate probability to move ffor a given moveState
-	double CalcProb2Move(state_t & stateVec, int *moveStates, size_t *arrOfIdx);
+	// append the name of a state to the buffer
+	void AppendStateName(ChunkBuffer& buffer, const int *stateVec, const char *type) const;
+	// append state in the output format (name or idx)
+	void AppendState(ChunkBuffer& buffer, size_t stateIdx, const char *type) const;
+	// name of action in the output format (name or idx)
+	const std::string& GetActionName(int action) const { return m_actionNames[action + 1]; }
 
 
 	// return true if the robot is in enemy range
-	bool InEnemyRange(state_t& stateVec);
-	bool InEnemyRangeIMP(state_t& stateVec, int advanceFactor);
+	bool InEnemyRange(const state_t& stateVec) const;
 
 	//Calculation Of Hits
-	void CalcHits(std::string& buffer);
-	void CalcHitsRec(state_t& array, size_t currIdx, std::string& buffer);
+	void CalcHits(ChunkBuffer& buffer);
 
+	// calculation of attacks from all states with robot location self
+	void CalcHitsSelf(int self, ChunkBuffer& buffer, Context& ctx);
 	// calculation of single state attacks
-	void CalcHitsSingleState(state_t& stateVec, std::string & buffer);
+	void CalcHitsSingleState(size_t stateIdx, ChunkBuffer& buffer, Context& ctx);
 
 	// calculation of hits for single state single direction attack
-	void CalcHitsSingleDirection(state_t& stateVec, int advanceFactor, std::string & prefix, std::string & buffer);
+	void CalcHitsSingleDirection(state_t& stateVec, size_t stateIdx, GridDirection direction, int action, ChunkBuffer& buffer, Context& ctx);
 
-	void CalcHitEnemy(state_t& stateVec, std::string & action, std::string & prefix, std::string & buffer);
-	void CalcHitNInv(state_t & stateVec, std::string & action, std::string & prefix, std::string & buffer);
+	void CalcHitEnemy(state_t& stateVec, size_t stateIdx, int action, ChunkBuffer& buffer, Context& ctx);
+	void CalcHitNInv(state_t & stateVec, size_t stateIdx, int action, ChunkBuffer& buffer, Context& ctx);
 
-	// returns true if the location is sheltered
-	bool SearchForShelter(int location);
-	// return true if state + advance factor is inside the grid
-	static bool InBoundary(int state, int advanceFactor, int gridSize);
 
 	//Calculation Of Observations
-	void CalcObs(std::string& buffer);
-	void CalcObsRec(state_t& stateVec, size_t currIdx, std::string& buffer);
-
-	void CalcObsSingleState(state_t& stateVec, std::string& buffer);
-	void CalcObsMapRec(state_t& stateVec, state_t& originalState, mapProb& pMap, std::vector<bool>& inRange, double pCurr, size_t currIdx);
-	void DivergeObs(state_t& stateVec, state_t& originalState, mapProb& pMap, std::vector<bool>& inRange, double pCurr, size_t currIdx, bool isPrevRange);
-	static bool InObsRange(int self, int object, size_t gridSize, size_t range);
+	void CalcObs(ChunkBuffer& buffer);
+
+	// calculate observations of all states with robot location self
+	void CalcObsSelf(int self, ChunkBuffer& buffer, Context& ctx);
+	void CalcObsSingleState(size_t stateIdx, ChunkBuffer& buffer, Context& ctx);
+	// calculate the observation factor of each object in the state (binary format)
+	void CalcObsFactors(size_t stateIdx, BinaryObservationFactor *factors);
+	void CalcObsMapRec(state_t& stateVec, state_t& originalState, ProbabilityAccumulator& pMap, std::vector<bool>& inRange, double pCurr, size_t currIdx);
+	void DivergeObs(state_t& stateVec, state_t& originalState, ProbabilityAccumulator& pMap, std::vector<bool>& inRange, double pCurr, size_t currIdx, bool isPrevRange);
+	bool InObsRange(int self, int object) const;
 	static size_t NextInLine(std::vector<bool>& inRange, size_t currIdx);
 	
 
 	// search for repetition in a stateVec or moveState.
 	static bool NoRepetition(state_t& stateVec, size_t currIdx);
-	static void NoRepetitionCheckAndCorrect(state_t& stateVec, int *moveStates, size_t *arrOfIdx);
 };
 
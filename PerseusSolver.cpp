@@ -0,0 +1,686 @@
+#include "PerseusSolver.h"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <future>
+#include <cmath>
+#include <type_traits>
+
+#include "ChunkBuffer.h"
+#include "TextFormat.h"
+
+// beliefs that are backed up together (the same batches with any number of threads)
+static const size_t s_batchSize = 16;
+// the bounds stop earlier when they converge
+static const size_t s_maxBoundIterations = 10000;
+// parts of a parallel loop for each thread (the parts of a loop are not equal in time)
+static const size_t s_partsPerThread = 4;
+
+template <typename T>
+bool PerseusSolver<T>::AlphaVectors::WriteAlpha(OutputSink& sink) const
+{
+	// float values keep the digits that read back to the same float
+	int precision = std::is_same<T, double>::value ? TextFormat::s_shortest : std::numeric_limits<T>::max_digits10;
+	ChunkBuffer buffer(sink);
+	for (size_t i = 0; i < GetNumVectors(); ++i)
+	{
+		buffer.AppendInteger(m_actions[i]);
+		buffer += '\n';
+		const T *values = GetVector(i);
+		for (size_t s = 0; s < m_numStates; ++s)
+		{
+			if (s > 0)
+			{
+				buffer += ' ';
+			}
+			buffer.AppendGeneral(values[s], precision);
+		}
+		buffer += "\n\n";
+	}
+
+	buffer.Flush();
+	return !buffer.IsFailed() && sink.Flush();
+}
+
+template <typename T>
+PerseusSolver<T>::PerseusSolver(const PomdpModel<T>& model, size_t threads)
+: m_model(model)
+, m_numStates(model.GetNumStates())
+, m_pool()
+, m_statesOfObservation()
+, m_observationSum(model.GetNumStates(), 0)
+, m_numBeliefs(1000)
+, m_horizon(50)
+, m_seed(1)
+, m_maxIterations(100)
+, m_maxSeconds(0.0)
+, m_epsilon(1e-3)
+, m_start()
+, m_beliefs()
+, m_alpha()
+, m_byState()
+, m_numVectors(0)
+, m_terminalValue(model.GetNumStates(), 0)
+{
+	if (threads > 1)
+	{
+		m_pool.reset(new ThreadPool(threads));
+	}
+
+	m_statesOfObservation = Transpose(model.m_observations);
+	for (size_t s = 0; s < m_numStates; ++s)
+	{
+		for (uint64_t k = model.m_observations.m_rowOffsets[s]; k < model.m_observations.m_rowOffsets[s + 1]; ++k)
+		{
+			m_observationSum[s] += model.m_observations.m_values[k];
+		}
+		if (model.m_start[s] > 0)
+		{
+			m_start.m_states.push_back(static_cast<uint32_t>(s));
+			m_start.m_p.push_back(model.m_start[s]);
+		}
+	}
+}
+
+template <typename T>
+void PerseusSolver<T>::SetBeliefs(size_t numBeliefs, size_t horizon, uint32_t seed)
+{
+	m_numBeliefs = numBeliefs > 0 ? numBeliefs : 1;
+	m_horizon = horizon > 0 ? horizon : 1;
+	m_seed = seed;
+}
+
+template <typename T>
+void PerseusSolver<T>::SetBudget(size_t maxIterations, double maxSeconds, double epsilon)
+{
+	m_maxIterations = maxIterations;
+	m_maxSeconds = maxSeconds;
+	m_epsilon = epsilon;
+}
+
+template <typename T>
+typename PerseusSolver<T>::AlphaVectors PerseusSolver<T>::CalcBlindPolicy(std::chrono::steady_clock::time_point start) const
+{
+	AlphaVectors alpha;
+	alpha.m_numStates = m_numStates;
+	if (!IsValidDiscount(m_model.m_discount))
+	{
+		return alpha;
+	}
+	alpha.m_values.resize(m_model.GetNumActions() * m_numStates);
+	for (size_t a = 0; a < m_model.GetNumActions(); ++a)
+	{
+		alpha.m_actions.push_back(static_cast<int>(a));
+	}
+
+	// from the min reward of each step: every iteration is a lower bound (the action and then at least the min reward)
+	double discount = m_model.m_discount;
+	double minReward = *std::min_element(m_model.m_rewards.begin(), m_model.m_rewards.end());
+	ParallelFor(m_model.GetNumActions(), [&](size_t begin, size_t end)
+	{
+		for (size_t a = begin; a < end; ++a)
+		{
+			std::vector<double> current(m_numStates, std::min(minReward, 0.0) / (1 - discount));
+			std::vector<double> next(m_numStates);
+			for (size_t i = 0; i < s_maxBoundIterations; ++i)
+			{
+				double change = 0.0;
+				for (size_t s = 0; s < m_numStates; ++s)
+				{
+					next[s] = m_model.m_rewards[s] + discount * RowDot(m_model.m_transitions[a], s, current.data());
+					change = std::max(change, std::abs(next[s] - current[s]));
+				}
+				current.swap(next);
+				if (change < m_epsilon * (1 - discount) || IsTimeOver(start))
+				{
+					break;
+				}
+			}
+			std::copy(current.begin(), current.end(), alpha.m_values.begin() + a * m_numStates);
+		}
+	});
+
+	return alpha;
+}
+
+template <typename T>
+typename PerseusSolver<T>::AlphaVectors PerseusSolver<T>::CalcQmdp(std::chrono::steady_clock::time_point start) const
+{
+	AlphaVectors alpha;
+	alpha.m_numStates = m_numStates;
+	if (!IsValidDiscount(m_model.m_discount))
+	{
+		return alpha;
+	}
+
+	// value iteration of the fully observed model from the max reward of each step: every iteration is an upper bound
+	double discount = m_model.m_discount;
+	double maxReward = *std::max_element(m_model.m_rewards.begin(), m_model.m_rewards.end());
+	std::vector<double> current(m_numStates, std::max(maxReward, 0.0) / (1 - discount));
+	std::vector<double> next(m_numStates);
+	std::vector<double> change(m_numStates);
+	for (size_t i = 0; i < s_maxBoundIterations; ++i)
+	{
+		ParallelFor(m_numStates, [&](size_t begin, size_t end)
+		{
+			for (size_t s = begin; s < end; ++s)
+			{
+				double best = -std::numeric_limits<double>::infinity();
+				for (const auto& transitions : m_model.m_transitions)
+				{
+					best = std::max(best, RowDot(transitions, s, current.data()));
+				}
+				next[s] = m_model.m_rewards[s] + discount * best;
+				change[s] = std::abs(next[s] - current[s]);
+			}
+		});
+		current.swap(next);
+		if (*std::max_element(change.begin(), change.end()) < m_epsilon * (1 - discount) || IsTimeOver(start))
+		{
+			break;
+		}
+	}
+
+	// the vector of an action is the action and then the fully observed value
+	alpha.m_values.resize(m_model.GetNumActions() * m_numStates);
+	for (size_t a = 0; a < m_model.GetNumActions(); ++a)
+	{
+		alpha.m_actions.push_back(static_cast<int>(a));
+		for (size_t s = 0; s < m_numStates; ++s)
+		{
+			alpha.m_values[a * m_numStates + s] = static_cast<T>(m_model.m_rewards[s] + discount * RowDot(m_model.m_transitions[a], s, current.data()));
+		}
+	}
+
+	return alpha;
+}
+
+template <typename T>
+typename PerseusSolver<T>::Result PerseusSolver<T>::Solve()
+{
+	auto start = std::chrono::steady_clock::now();
+	Result result;
+	m_alpha = AlphaVectors();
+	m_alpha.m_numStates = m_numStates;
+	if (!IsValidDiscount(m_model.m_discount))
+	{
+		return result;
+	}
+
+	result.m_upperBound = Value(CalcQmdp(start), m_start);
+	m_alpha = CalcBlindPolicy(start);
+
+	std::vector<Scratch> scratch(s_batchSize);
+	for (auto & s : scratch)
+	{
+		InitScratch(s);
+	}
+	std::mt19937 random(m_seed);
+	CollectBeliefs(random, scratch[0]);
+
+	size_t numBeliefs = m_beliefs.size();
+	std::vector<double> values(numBeliefs);
+	std::vector<double> newValues(numBeliefs);
+	std::vector<size_t> best(numBeliefs);
+	std::vector<size_t> remaining;
+	bool isTimeOver = false;
+	while (result.m_iterations < m_maxIterations && !isTimeOver)
+	{
+		SetStageVectors();
+		ParallelFor(numBeliefs, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				values[i] = Value(m_alpha, m_beliefs[i], &best[i]);
+				newValues[i] = -std::numeric_limits<double>::infinity();
+			}
+		});
+
+		AlphaVectors next;
+		next.m_numStates = m_numStates;
+		std::vector<char> isAdded(m_alpha.GetNumVectors(), 0);
+		remaining.resize(numBeliefs);
+		std::iota(remaining.begin(), remaining.end(), 0);
+		while (!remaining.empty())
+		{
+			// random beliefs that were not improved yet are moved to the end of remaining
+			size_t batch = std::min(s_batchSize, remaining.size());
+			for (size_t i = 0; i < batch; ++i)
+			{
+				size_t last = remaining.size() - 1 - i;
+				std::swap(remaining[std::uniform_int_distribution<size_t>(0, last)(random)], remaining[last]);
+			}
+			const size_t *batchIdx = &remaining[remaining.size() - batch];
+			ParallelFor(batch, [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					Backup(m_beliefs[batchIdx[i]], best[batchIdx[i]], scratch[i]);
+				}
+			});
+			result.m_backups += batch;
+
+			// a backup that doesn't improve its belief is replaced by the best vector of the belief from the previous stage
+			size_t firstNew = next.GetNumVectors();
+			for (size_t i = 0; i < batch; ++i)
+			{
+				size_t idx = batchIdx[i];
+				if (Dot(scratch[i].m_alpha.data(), m_beliefs[idx]) >= values[idx])
+				{
+					next.Add(scratch[i].m_action, scratch[i].m_alpha.data());
+				}
+				else if (!isAdded[best[idx]])
+				{
+					isAdded[best[idx]] = 1;
+					next.Add(m_alpha.m_actions[best[idx]], m_alpha.GetVector(best[idx]));
+				}
+			}
+
+			// the beliefs that are improved by the new vectors are done
+			ParallelFor(remaining.size(), [&](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					size_t idx = remaining[i];
+					for (size_t v = firstNew; v < next.GetNumVectors(); ++v)
+					{
+						newValues[idx] = std::max(newValues[idx], Dot(next.GetVector(v), m_beliefs[idx]));
+					}
+				}
+			});
+			remaining.erase(std::remove_if(remaining.begin(), remaining.end(), [&](size_t idx) { return newValues[idx] >= values[idx]; }), remaining.end());
+
+			// the stage ends with the previous vectors of the beliefs that were not improved (the value of a belief never decreases)
+			isTimeOver = IsTimeOver(start);
+			if (isTimeOver)
+			{
+				for (size_t idx : remaining)
+				{
+					if (!isAdded[best[idx]])
+					{
+						isAdded[best[idx]] = 1;
+						next.Add(m_alpha.m_actions[best[idx]], m_alpha.GetVector(best[idx]));
+					}
+					newValues[idx] = values[idx];
+				}
+				remaining.clear();
+			}
+		}
+
+		double improvement = 0.0;
+		for (size_t i = 0; i < numBeliefs; ++i)
+		{
+			improvement = std::max(improvement, newValues[i] - values[i]);
+		}
+		m_alpha = std::move(next);
+		++result.m_iterations;
+		if (improvement < m_epsilon)
+		{
+			result.m_isConverged = true;
+			break;
+		}
+	}
+
+	std::vector<T>().swap(m_byState);
+	result.m_numBeliefs = numBeliefs;
+	result.m_numVectors = m_alpha.GetNumVectors();
+	result.m_lowerBound = Value(m_alpha, m_start);
+	result.m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+template <typename T>
+double PerseusSolver<T>::Value(const AlphaVectors& alpha, const Belief& belief, size_t *best) const
+{
+	double value = -std::numeric_limits<double>::infinity();
+	for (size_t i = 0; i < alpha.GetNumVectors(); ++i)
+	{
+		double v = Dot(alpha.GetVector(i), belief);
+		if (v > value)
+		{
+			value = v;
+			if (nullptr != best)
+			{
+				*best = i;
+			}
+		}
+	}
+
+	return value;
+}
+
+template <typename T>
+bool PerseusSolver<T>::IsTimeOver(std::chrono::steady_clock::time_point start) const
+{
+	return m_maxSeconds > 0 && std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= m_maxSeconds;
+}
+
+template <typename T>
+void PerseusSolver<T>::ParallelFor(size_t size, const std::function<void(size_t, size_t)>& run) const
+{
+	if (nullptr == m_pool || size < 2)
+	{
+		run(0, size);
+		return;
+	}
+
+	size_t numParts = std::min(size, s_partsPerThread * m_pool->GetNumThreads());
+	std::vector<std::future<void>> done;
+	done.reserve(numParts);
+	for (size_t i = 0; i < numParts; ++i)
+	{
+		size_t begin = size * i / numParts;
+		size_t end = size * (i + 1) / numParts;
+		done.push_back(m_pool->Submit([&run, begin, end]() { run(begin, end); }));
+	}
+
+	for (auto & d : done)
+	{
+		d.get();
+	}
+}
+
+template <typename T>
+void PerseusSolver<T>::InitScratch(Scratch& scratch) const
+{
+	scratch.m_predicted.assign(m_numStates, 0);
+	scratch.m_isObserved.assign(m_model.GetNumObservations(), 0);
+	scratch.m_choices.resize(m_model.GetNumActions());
+	scratch.m_continuation.resize(m_numStates);
+	scratch.m_alpha.resize(m_numStates);
+}
+
+template <typename T>
+void PerseusSolver<T>::Predict(const Belief& belief, size_t action, Scratch& scratch) const
+{
+	const CsrMatrixT<T>& transitions = m_model.m_transitions[action];
+	for (size_t i = 0; i < belief.m_states.size(); ++i)
+	{
+		uint32_t state = belief.m_states[i];
+		for (uint64_t k = transitions.m_rowOffsets[state]; k < transitions.m_rowOffsets[state + 1]; ++k)
+		{
+			T p = belief.m_p[i] * transitions.m_values[k];
+			uint32_t endState = transitions.m_columns[k];
+			if (0 == scratch.m_predicted[endState])
+			{
+				if (0 == p)
+				{
+					continue;
+				}
+				scratch.m_support.push_back(endState);
+			}
+			scratch.m_predicted[endState] += p;
+		}
+	}
+}
+
+template <typename T>
+void PerseusSolver<T>::ClearPredicted(Scratch& scratch) const
+{
+	for (uint32_t state : scratch.m_support)
+	{
+		scratch.m_predicted[state] = 0;
+	}
+	scratch.m_support.clear();
+}
+
+template <typename T>
+void PerseusSolver<T>::CollectBeliefs(std::mt19937& random, Scratch& scratch)
+{
+	m_beliefs.assign(1, m_start);
+	std::uniform_int_distribution<size_t> randomAction(0, m_model.GetNumActions() - 1);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const CsrMatrixT<T>& observations = m_model.m_observations;
+
+	// a walk ends in an end-state that is observed by itself or after horizon steps (the steps are bounded for a start that always ends)
+	Belief belief = m_start;
+	size_t steps = 0;
+	for (size_t walk = 0; m_beliefs.size() < m_numBeliefs && walk < m_numBeliefs * m_horizon; ++walk)
+	{
+		Predict(belief, randomAction(random), scratch);
+		double total = 0.0;
+		for (uint32_t state : scratch.m_support)
+		{
+			total += scratch.m_predicted[state];
+		}
+
+		// sample the end-state and then its observation
+		uint32_t endState = 0;
+		double left = unit(random) * total;
+		for (uint32_t state : scratch.m_support)
+		{
+			endState = state;
+			left -= scratch.m_predicted[state];
+			if (left < 0)
+			{
+				break;
+			}
+		}
+
+		bool isEnd = 0 == total || IsTerminal(endState) || ++steps >= m_horizon;
+		Belief next;
+		if (!isEnd)
+		{
+			uint64_t k = observations.m_rowOffsets[endState];
+			left = unit(random) * m_observationSum[endState];
+			for (; k + 1 < observations.m_rowOffsets[endState + 1]; ++k)
+			{
+				left -= observations.m_values[k];
+				if (left < 0)
+				{
+					break;
+				}
+			}
+
+			// the belief after the observation (the end-states of an observation are sorted)
+			uint32_t observation = observations.m_columns[k];
+			double sum = 0.0;
+			for (uint64_t j = m_statesOfObservation.m_rowOffsets[observation]; j < m_statesOfObservation.m_rowOffsets[observation + 1]; ++j)
+			{
+				uint32_t state = m_statesOfObservation.m_columns[j];
+				T p = scratch.m_predicted[state] * m_statesOfObservation.m_values[j];
+				if (p > 0)
+				{
+					next.m_states.push_back(state);
+					next.m_p.push_back(p);
+					sum += p;
+				}
+			}
+			for (auto & p : next.m_p)
+			{
+				p = static_cast<T>(p / sum);
+			}
+		}
+		ClearPredicted(scratch);
+
+		if (isEnd)
+		{
+			belief = m_start;
+			steps = 0;
+			continue;
+		}
+		m_beliefs.push_back(next);
+		belief = std::move(next);
+	}
+}
+
+template <typename T>
+void PerseusSolver<T>::SetStageVectors()
+{
+	m_numVectors = m_alpha.GetNumVectors();
+	m_byState.resize(m_numStates * m_numVectors);
+	ParallelFor(m_numStates, [&](size_t begin, size_t end)
+	{
+		for (size_t s = begin; s < end; ++s)
+		{
+			T *values = &m_byState[s * m_numVectors];
+			for (size_t i = 0; i < m_numVectors; ++i)
+			{
+				values[i] = m_alpha.GetVector(i)[s];
+			}
+			m_terminalValue[s] = IsTerminal(s) ? *std::max_element(values, values + m_numVectors) : 0;
+		}
+	});
+}
+
+template <typename T>
+void PerseusSolver<T>::Backup(const Belief& belief, size_t defaultVector, Scratch& scratch) const
+{
+	size_t numVectors = m_numVectors;
+	scratch.m_scores.resize(numVectors);
+	T *scores = scratch.m_scores.data();
+
+	// the value of each action is the sum of the best vector of each possible observation
+	// (the vectors of a state are contiguous so the scores of all the vectors are a single vectorized loop)
+	double bestValue = -std::numeric_limits<double>::infinity();
+	for (size_t a = 0; a < m_model.GetNumActions(); ++a)
+	{
+		Predict(belief, a, scratch);
+		auto& choices = scratch.m_choices[a];
+		choices.clear();
+		double value = 0.0;
+		for (uint32_t state : scratch.m_support)
+		{
+			if (IsTerminal(state))
+			{
+				value += scratch.m_predicted[state] * m_terminalValue[state];
+				continue;
+			}
+			for (uint64_t k = m_model.m_observations.m_rowOffsets[state]; k < m_model.m_observations.m_rowOffsets[state + 1]; ++k)
+			{
+				uint32_t observation = m_model.m_observations.m_columns[k];
+				if (!scratch.m_isObserved[observation])
+				{
+					scratch.m_isObserved[observation] = 1;
+					scratch.m_observations.push_back(observation);
+				}
+			}
+		}
+
+		for (uint32_t observation : scratch.m_observations)
+		{
+			scratch.m_isObserved[observation] = 0;
+			std::fill(scores, scores + numVectors, T(0));
+			for (uint64_t k = m_statesOfObservation.m_rowOffsets[observation]; k < m_statesOfObservation.m_rowOffsets[observation + 1]; ++k)
+			{
+				uint32_t state = m_statesOfObservation.m_columns[k];
+				T w = scratch.m_predicted[state] * m_statesOfObservation.m_values[k];
+				if (0 == w)
+				{
+					continue;
+				}
+				const T *values = &m_byState[state * numVectors];
+				for (size_t i = 0; i < numVectors; ++i)
+				{
+					scores[i] += w * values[i];
+				}
+			}
+
+			// ties keep the default vector
+			size_t best = defaultVector;
+			for (size_t i = 0; i < numVectors; ++i)
+			{
+				if (scores[i] > scores[best])
+				{
+					best = i;
+				}
+			}
+			value += scores[best];
+			if (best != defaultVector)
+			{
+				choices.emplace_back(observation, static_cast<uint32_t>(best));
+			}
+		}
+		scratch.m_observations.clear();
+		ClearPredicted(scratch);
+
+		if (value > bestValue)
+		{
+			bestValue = value;
+			scratch.m_action = static_cast<int>(a);
+		}
+	}
+
+	// the value after each end-state: the default vector for all the observations and the chosen vector of the observations of the belief
+	T *continuation = scratch.m_continuation.data();
+	for (size_t s = 0; s < m_numStates; ++s)
+	{
+		continuation[s] = IsTerminal(s) ? m_terminalValue[s] : m_observationSum[s] * m_byState[s * numVectors + defaultVector];
+	}
+	for (const auto& choice : scratch.m_choices[scratch.m_action])
+	{
+		for (uint64_t k = m_statesOfObservation.m_rowOffsets[choice.first]; k < m_statesOfObservation.m_rowOffsets[choice.first + 1]; ++k)
+		{
+			const T *values = &m_byState[m_statesOfObservation.m_columns[k] * numVectors];
+			continuation[m_statesOfObservation.m_columns[k]] += m_statesOfObservation.m_values[k] * (values[choice.second] - values[defaultVector]);
+		}
+	}
+
+	const CsrMatrixT<T>& transitions = m_model.m_transitions[scratch.m_action];
+	for (size_t s = 0; s < m_numStates; ++s)
+	{
+		double sum = 0.0;
+		for (uint64_t k = transitions.m_rowOffsets[s]; k < transitions.m_rowOffsets[s + 1]; ++k)
+		{
+			sum += transitions.m_values[k] * continuation[transitions.m_columns[k]];
+		}
+		scratch.m_alpha[s] = static_cast<T>(m_model.m_rewards[s] + m_model.m_discount * sum);
+	}
+}
+
+template <typename T>
+double PerseusSolver<T>::Dot(const T *values, const Belief& belief)
+{
+	double sum = 0.0;
+	for (size_t i = 0; i < belief.m_states.size(); ++i)
+	{
+		sum += belief.m_p[i] * values[belief.m_states[i]];
+	}
+
+	return sum;
+}
+
+template <typename T>
+double PerseusSolver<T>::RowDot(const CsrMatrixT<T>& matrix, size_t row, const double *values)
+{
+	double sum = 0.0;
+	for (uint64_t k = matrix.m_rowOffsets[row]; k < matrix.m_rowOffsets[row + 1]; ++k)
+	{
+		sum += matrix.m_values[k] * values[matrix.m_columns[k]];
+	}
+
+	return sum;
+}
+
+template <typename T>
+CsrMatrixT<T> PerseusSolver<T>::Transpose(const CsrMatrixT<T>& matrix)
+{
+	CsrMatrixT<T> transposed;
+	transposed.m_numCols = matrix.GetNumRows();
+	transposed.m_rowOffsets.assign(matrix.m_numCols + 1, 0);
+	for (uint32_t col : matrix.m_columns)
+	{
+		++transposed.m_rowOffsets[col + 1];
+	}
+	std::partial_sum(transposed.m_rowOffsets.begin(), transposed.m_rowOffsets.end(), transposed.m_rowOffsets.begin());
+
+	// the rows are added in order so the columns of each row of the transpose are sorted
+	transposed.m_columns.resize(matrix.m_columns.size());
+	transposed.m_values.resize(matrix.m_values.size());
+	std::vector<uint64_t> next(transposed.m_rowOffsets.begin(), transposed.m_rowOffsets.end() - 1);
+	for (size_t row = 0; row < matrix.GetNumRows(); ++row)
+	{
+		for (uint64_t k = matrix.m_rowOffsets[row]; k < matrix.m_rowOffsets[row + 1]; ++k)
+		{
+			uint64_t pos = next[matrix.m_columns[k]]++;
+			transposed.m_columns[pos] = static_cast<uint32_t>(row);
+			transposed.m_values[pos] = matrix.m_values[k];
+		}
+	}
+
+	return transposed;
+}
+
+template class PerseusSolver<float>;
+template class PerseusSolver<double>;
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+
+#include "PomdpModel.h"
+#include "OutputSink.h"
+#include "ThreadPool.h"
+
+//	point-based value iteration (perseus) on a model in memory (see POMDP_Writer::BuildModel).
+//	the beliefs are collected by random walks from the start and each stage backs up random beliefs until the value of
+//	all the beliefs is improved. the beliefs of a stage are backed up in batches and the beliefs of a batch are backed up
+//	in parallel (the batches don't depend on the number of threads so the vectors are the same with any number of threads).
+//	an end-state without observations (win and loss) is observed by itself.
+//	the blind policy (lower bound) and qmdp (upper bound) are the fast bounds of the solver
+template <typename T>
+class PerseusSolver
+{
+public:
+	// the value of a belief is the max of the dot products of the belief with the vectors
+	struct AlphaVectors
+	{
+		size_t m_numStates = 0;
+		std::vector<int> m_actions;
+		// vector i is [i * m_numStates, (i + 1) * m_numStates)
+		std::vector<T> m_values;
+
+		size_t GetNumVectors() const { return m_actions.size(); }
+		const T *GetVector(size_t i) const { return &m_values[i * m_numStates]; }
+		void Add(int action, const T *values) { m_actions.push_back(action); m_values.insert(m_values.end(), values, values + m_numStates); }
+		// write in the .alpha format of pomdp-solve: the action of each vector in a line, its values in the next line and an empty line
+		bool WriteAlpha(OutputSink& sink) const;
+	};
+
+	// sparse belief (the states are sorted)
+	struct Belief
+	{
+		std::vector<uint32_t> m_states;
+		std::vector<T> m_p;
+	};
+
+	struct Result
+	{
+		size_t m_iterations = 0;
+		size_t m_backups = 0;
+		size_t m_numBeliefs = 0;
+		size_t m_numVectors = 0;
+		double m_seconds = 0.0;
+		// value of the start by the vectors (lower bound) and by qmdp (upper bound)
+		double m_lowerBound = 0.0;
+		double m_upperBound = 0.0;
+		// the last stage improved the value of each belief by less than epsilon
+		bool m_isConverged = false;
+	};
+
+	// the model is kept by reference (see IsValidDiscount). with threads > 1 the beliefs are backed up on a pool of the solver
+	explicit PerseusSolver(const PomdpModel<T>& model, size_t threads = 1);
+	~PerseusSolver() = default;
+	PerseusSolver(const PerseusSolver&) = delete;
+	PerseusSolver& operator=(const PerseusSolver&) = delete;
+
+	// collect numBeliefs beliefs by random walks of at most horizon steps (default 1000 beliefs, 50 steps)
+	void SetBeliefs(size_t numBeliefs, size_t horizon, uint32_t seed = 1);
+	// stop after maxIterations stages, after maxSeconds (0 for no limit) or when a stage improves less than epsilon
+	// (default 100 stages, no limit and 1e-3). epsilon is also the precision of the bounds
+	void SetBudget(size_t maxIterations, double maxSeconds, double epsilon = 1e-3);
+
+	// the bounds and the stages converge only with discount in [0, 1): a model with another discount has no vectors
+	static bool IsValidDiscount(double discount) { return discount >= 0.0 && discount < 1.0; }
+
+	// vector of each action for the policy that repeats the action (a lower bound).
+	// the iterations stop when the time of the budget from start is over (every iteration is a bound)
+	AlphaVectors CalcBlindPolicy(std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now()) const;
+	// vector of each action for the fully observed model after the action (an upper bound)
+	AlphaVectors CalcQmdp(std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now()) const;
+
+	// improve the vectors of the blind policy until the budget ends (an empty result with a discount that is not valid)
+	Result Solve();
+	const AlphaVectors& GetAlphaVectors() const { return m_alpha; }
+	const Belief& GetStart() const { return m_start; }
+
+	// value of belief by the vectors (best is the idx of the vector with the value)
+	double Value(const AlphaVectors& alpha, const Belief& belief, size_t *best = nullptr) const;
+
+private:
+	// memory of a single backup (the dense arrays are zero between backups)
+	struct Scratch
+	{
+		std::vector<T> m_predicted;
+		std::vector<uint32_t> m_support;
+		std::vector<char> m_isObserved;
+		std::vector<uint32_t> m_observations;
+		std::vector<T> m_scores;
+		// observations that their vector is not the default vector of the backup (observation, vector) of each action
+		std::vector<std::vector<std::pair<uint32_t, uint32_t>>> m_choices;
+		std::vector<T> m_continuation;
+		std::vector<T> m_alpha;
+		int m_action = 0;
+	};
+
+	const PomdpModel<T>& m_model;
+	size_t m_numStates;
+	// workers of the parallel loops (exists only with more than 1 thread)
+	std::unique_ptr<ThreadPool> m_pool;
+	// the end-states of each observation (the transpose of the observations of the model)
+	CsrMatrixT<T> m_statesOfObservation;
+	// probability of all observations in each end-state (0 for an end-state that is observed by itself)
+	std::vector<T> m_observationSum;
+
+	size_t m_numBeliefs;
+	size_t m_horizon;
+	uint32_t m_seed;
+	size_t m_maxIterations;
+	double m_maxSeconds;
+	double m_epsilon;
+
+	Belief m_start;
+	std::vector<Belief> m_beliefs;
+	AlphaVectors m_alpha;
+	// the vectors of the stage by state: the values of all the vectors in a state are contiguous
+	std::vector<T> m_byState;
+	size_t m_numVectors;
+	// max value of the vectors of the stage in each end-state that is observed by itself
+	std::vector<T> m_terminalValue;
+
+	bool IsTerminal(size_t state) const { return 0 == m_observationSum[state]; }
+	bool IsTimeOver(std::chrono::steady_clock::time_point start) const;
+	// run [begin, end) parts of [0, size) on the pool (or all of it in the calling thread)
+	void ParallelFor(size_t size, const std::function<void(size_t, size_t)>& run) const;
+
+	void InitScratch(Scratch& scratch) const;
+	// the probability of each end-state after action (in scratch.m_predicted and its support)
+	void Predict(const Belief& belief, size_t action, Scratch& scratch) const;
+	void ClearPredicted(Scratch& scratch) const;
+	void CollectBeliefs(std::mt19937& random, Scratch& scratch);
+	// set the vectors of the stage by state
+	void SetStageVectors();
+	// the best vector of belief from the vectors of the stage (the vector of an observation that is not possible is defaultVector)
+	void Backup(const Belief& belief, size_t defaultVector, Scratch& scratch) const;
+
+	static double Dot(const T *values, const Belief& belief);
+	// transition row of state dot values
+	static double RowDot(const CsrMatrixT<T>& matrix, size_t row, const double *values);
+	static CsrMatrixT<T> Transpose(const CsrMatrixT<T>& matrix);
+};
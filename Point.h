@@ -1,4 +1,7 @@
 #pragma once
+
+#include <cstddef>
+
 class Point
 {
 public:
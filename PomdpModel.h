@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+#include "SparseModelBuilder.h"
+
+//	the pomdp model in memory (see POMDP_Writer::BuildModel): the model of the text of SaveInFormat
+//	as sparse matrices for a solver in the same process. the probabilities and the rewards are float or double.
+//	repeated end-states of a row are summed as in SaveBinary: the text repeats the line of Win in the rows of the shots
+//	with the robot in the target, and a parser that keeps the last line of an end-state reads only part of these rows.
+//	the states are in the order of the text (live states, dead states, win and loss) and so are the observations
+template <typename T>
+struct PomdpModel
+{
+	double m_discount = 0.0;
+	// transitions of each action (numStates x numStates) in the order of the actions
+	std::vector<CsrMatrixT<T>> m_transitions;
+	// probability of each observation in each end-state for all actions (numStates x numObservations, the rows of win and loss are empty)
+	CsrMatrixT<T> m_observations;
+	// reward for acting in each state
+	std::vector<T> m_rewards;
+	// initial probability of each state
+	std::vector<T> m_start;
+
+	// names of the text (also when the text is written with idx)
+	std::vector<std::string> m_stateNames;
+	std::vector<std::string> m_actionNames;
+	std::vector<std::string> m_observationNames;
+	// idx of each state in StateIndexer (only when the model was pruned, otherwise the states are all the states of StateIndexer)
+	std::vector<uint64_t> m_stateIds;
+
+	size_t GetNumStates() const { return m_rewards.size(); }
+	size_t GetNumActions() const { return m_transitions.size(); }
+	size_t GetNumObservations() const { return m_observations.m_numCols; }
+};
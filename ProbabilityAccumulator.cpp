@@ -0,0 +1,77 @@
+#include "ProbabilityAccumulator.h"
+
+#include <algorithm>
+
+static const size_t s_initialSlots = 64;
+
+const uint32_t ProbabilityAccumulator::s_emptySlot;
+
+ProbabilityAccumulator::ProbabilityAccumulator()
+: m_slots(s_initialSlots, s_emptySlot)
+, m_usedSlots()
+, m_entries()
+, m_mask(s_initialSlots - 1)
+{
+}
+
+void ProbabilityAccumulator::Clear()
+{
+	for (auto slot : m_usedSlots)
+	{
+		m_slots[slot] = s_emptySlot;
+	}
+	m_usedSlots.clear();
+	m_entries.clear();
+}
+
+void ProbabilityAccumulator::Sort()
+{
+	std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) { return a.m_idx < b.m_idx; });
+}
+
+size_t ProbabilityAccumulator::Find(size_t idx)
+{
+	size_t slot = FindSlot(idx);
+	if (s_emptySlot != m_slots[slot])
+	{
+		return m_slots[slot];
+	}
+
+	// keep the table at most half full
+	if (2 * (m_entries.size() + 1) > m_slots.size())
+	{
+		Grow();
+		slot = FindSlot(idx);
+	}
+
+	m_slots[slot] = static_cast<uint32_t>(m_entries.size());
+	m_usedSlots.push_back(static_cast<uint32_t>(slot));
+	m_entries.push_back(Entry{ idx, 0.0 });
+	return m_entries.size() - 1;
+}
+
+size_t ProbabilityAccumulator::FindSlot(size_t idx) const
+{
+	// linear probing from the hash of the idx until the idx or an empty slot
+	size_t slot = (idx * 0x9E3779B97F4A7C15ull >> 16) & m_mask;
+	while (s_emptySlot != m_slots[slot] && m_entries[m_slots[slot]].m_idx != idx)
+	{
+		slot = (slot + 1) & m_mask;
+	}
+
+	return slot;
+}
+
+void ProbabilityAccumulator::Grow()
+{
+	m_slots.assign(2 * m_slots.size(), s_emptySlot);
+	m_mask = m_slots.size() - 1;
+	m_usedSlots.clear();
+
+	for (size_t i = 0; i < m_entries.size(); ++i)
+	{
+		size_t slot = FindSlot(m_entries[i].m_idx);
+		m_slots[slot] = static_cast<uint32_t>(i);
+		m_usedSlots.push_back(static_cast<uint32_t>(slot));
+	}
+}
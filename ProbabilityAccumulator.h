@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+//	accumulates the probabilities of the end-states of a single row by the idx of the state (open addressing hash table).
+//	the accumulator is cleared and reused for each row so it allocates only when a row is bigger than all previous rows.
+//	the entries are kept in their order of insertion until Sort (sum of repeated idx is done in the order of the calls)
+class ProbabilityAccumulator
+{
+public:
+	struct Entry
+	{
+		size_t m_idx;
+		double m_p;
+	};
+
+	ProbabilityAccumulator();
+
+	// add p to the probability of idx
+	void Add(size_t idx, double p) { m_entries[Find(idx)].m_p += p; }
+	// replace the probability of idx with p
+	void Set(size_t idx, double p) { m_entries[Find(idx)].m_p = p; }
+
+	void Clear();
+	// sort the entries by idx. no more entries can be added until Clear
+	void Sort();
+
+	size_t GetSize() const { return m_entries.size(); }
+	const Entry& operator[](size_t i) const { return m_entries[i]; }
+	std::vector<Entry>::const_iterator begin() const { return m_entries.begin(); }
+	std::vector<Entry>::const_iterator end() const { return m_entries.end(); }
+
+private:
+	static const uint32_t s_emptySlot = UINT32_MAX;
+
+	// position in m_entries of each slot (s_emptySlot for empty slot)
+	std::vector<uint32_t> m_slots;
+	// slot of each entry (to clear only the used slots)
+	std::vector<uint32_t> m_usedSlots;
+	std::vector<Entry> m_entries;
+	size_t m_mask;
+
+	// returns the position of idx in m_entries (a new entry with p = 0 is inserted if idx is missing)
+	size_t Find(size_t idx);
+	size_t FindSlot(size_t idx) const;
+	void Grow();
+};
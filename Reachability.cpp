@@ -0,0 +1,98 @@
+#include "Reachability.h"
+
+const uint32_t Reachability::s_unreachable;
+
+Reachability::Reachability(const std::vector<CsrMatrix>& transitions, const std::vector<size_t>& startStates, const std::vector<size_t>& keptStates)
+: m_newIdx()
+, m_states()
+{
+	size_t numStates = transitions.empty() ? 0 : transitions[0].GetNumRows();
+	std::vector<bool> isReached(numStates, false);
+	std::vector<size_t> queue;
+
+	for (size_t state : startStates)
+	{
+		if (!isReached[state])
+		{
+			isReached[state] = true;
+			queue.push_back(state);
+		}
+	}
+
+	// the queue keeps all the states that were reached (head is the next state to expand).
+	// entries with probability 0 are not followed
+	for (size_t head = 0; head < queue.size(); ++head)
+	{
+		size_t state = queue[head];
+		for (const auto& matrix : transitions)
+		{
+			for (uint64_t i = matrix.m_rowOffsets[state]; i < matrix.m_rowOffsets[state + 1]; ++i)
+			{
+				uint32_t endState = matrix.m_columns[i];
+				if (matrix.m_values[i] > 0.0 && !isReached[endState])
+				{
+					isReached[endState] = true;
+					queue.push_back(endState);
+				}
+			}
+		}
+	}
+
+	for (size_t state : keptStates)
+	{
+		isReached[state] = true;
+	}
+
+	m_newIdx.assign(numStates, s_unreachable);
+	for (size_t state = 0; state < numStates; ++state)
+	{
+		if (isReached[state])
+		{
+			m_newIdx[state] = static_cast<uint32_t>(m_states.size());
+			m_states.push_back(state);
+		}
+	}
+}
+
+CsrMatrix Reachability::Prune(const CsrMatrix& matrix) const
+{
+	CsrMatrix pruned;
+	pruned.m_numCols = m_states.size();
+	pruned.m_rowOffsets.reserve(m_states.size() + 1);
+	pruned.m_rowOffsets.push_back(0);
+
+	// the end-states of a reachable state that are not reachable have probability 0 and are removed
+	for (uint64_t state : m_states)
+	{
+		for (uint64_t i = matrix.m_rowOffsets[state]; i < matrix.m_rowOffsets[state + 1]; ++i)
+		{
+			if (IsReachable(matrix.m_columns[i]))
+			{
+				pruned.m_columns.push_back(m_newIdx[matrix.m_columns[i]]);
+				pruned.m_values.push_back(matrix.m_values[i]);
+			}
+		}
+		pruned.m_rowOffsets.push_back(pruned.m_values.size());
+	}
+
+	return pruned;
+}
+
+CsrMatrix Reachability::PruneRows(const CsrMatrix& matrix) const
+{
+	CsrMatrix pruned;
+	pruned.m_numCols = matrix.m_numCols;
+	pruned.m_rowOffsets.reserve(m_states.size() + 1);
+	pruned.m_rowOffsets.push_back(0);
+
+	for (uint64_t state : m_states)
+	{
+		uint64_t begin = matrix.m_rowOffsets[state];
+		uint64_t end = matrix.m_rowOffsets[state + 1];
+		pruned.m_columns.insert(pruned.m_columns.end(), matrix.m_columns.begin() + begin, matrix.m_columns.begin() + end);
+		pruned.m_values.insert(pruned.m_values.end(), matrix.m_values.begin() + begin, matrix.m_values.begin() + end);
+		pruned.m_rowOffsets.push_back(pruned.m_values.size());
+	}
+
+	return pruned;
+}
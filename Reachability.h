@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include "SparseModelBuilder.h"
+
+//	the states that can be reached from the start states by the transitions of any action with probability above 0 (breadth first search).
+//	the reachable states get new idx in the order of their original idx so the relative order of the states is kept
+class Reachability
+{
+public:
+	// new idx of a state that is not reachable
+	static const uint32_t s_unreachable = UINT32_MAX;
+
+	// transitions of each action (numStates x numStates). the kept states are reachable even when no state reaches them
+	Reachability(const std::vector<CsrMatrix>& transitions, const std::vector<size_t>& startStates, const std::vector<size_t>& keptStates);
+	~Reachability() = default;
+
+	bool IsReachable(size_t state) const { return s_unreachable != m_newIdx[state]; }
+	uint32_t GetNewIdx(size_t state) const { return m_newIdx[state]; }
+	size_t GetNumReachable() const { return m_states.size(); }
+	// original idx of each reachable state (in the order of the new idx)
+	const std::vector<uint64_t>& GetStates() const { return m_states; }
+
+	// the rows and the columns of the reachable states with the new idx (without the entries of states that are not reachable)
+	CsrMatrix Prune(const CsrMatrix& matrix) const;
+	// the rows of the reachable states (the columns are not states and are kept)
+	CsrMatrix PruneRows(const CsrMatrix& matrix) const;
+	// the values of the reachable states (size values of each state)
+	template <typename T>
+	std::vector<T> Prune(const std::vector<T>& values, size_t size = 1) const;
+
+private:
+	std::vector<uint32_t> m_newIdx;
+	std::vector<uint64_t> m_states;
+};
+
+template <typename T>
+std::vector<T> Reachability::Prune(const std::vector<T>& values, size_t size) const
+{
+	std::vector<T> pruned;
+	pruned.reserve(m_states.size() * size);
+	for (uint64_t state : m_states)
+	{
+		pruned.insert(pruned.end(), values.begin() + state * size, values.begin() + (state + 1) * size);
+	}
+
+	return pruned;
+}
@@ -0,0 +1,140 @@
+#include "SectionCache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <vector>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <functional>
+
+const uint64_t ContentHash::s_offsetBasis;
+const uint64_t ContentHash::s_prime;
+
+// size of the chunks copied from an entry to the output
+static const size_t s_readChunkSize = 1 << 16;
+
+void ContentHash::Add(const void *data, size_t size)
+{
+	const unsigned char *bytes = static_cast<const unsigned char *>(data);
+	for (size_t i = 0; i < size; ++i)
+	{
+		m_hash = (m_hash ^ bytes[i]) * s_prime;
+	}
+}
+
+SectionCache::SectionCache(const std::string& directory)
+: m_directory(directory)
+{
+}
+
+SectionCache::ReadStatus SectionCache::Read(uint64_t key, OutputSink& sink) const
+{
+	FILE *entry = FileSink::Open(GetPath(key).c_str(), "rb");
+	if (nullptr == entry)
+	{
+		return READ_MISSING;
+	}
+
+	// once the entry is open part of it may be written so a failure can't fall back to calculating the section
+	std::vector<char> chunk(s_readChunkSize);
+	size_t size;
+	bool isWritten = true;
+	while (isWritten && (size = fread(chunk.data(), 1, chunk.size(), entry)) > 0)
+	{
+		isWritten = sink.Write(chunk.data(), size);
+	}
+	bool isError = !isWritten || ferror(entry) != 0;
+	fclose(entry);
+
+	return isError ? READ_FAILED : READ_DONE;
+}
+
+std::string SectionCache::GetPath(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.sec", static_cast<unsigned long long>(key));
+	return m_directory + "/" + name;
+}
+
+// suffix of a new entry that no other writer of the directory uses: the process (a random token for the processes of
+// other hosts with the same pid), the thread and a counter of the entries of the process
+static std::string UniqueTmpSuffix()
+{
+	static const unsigned long long s_token = (static_cast<unsigned long long>(std::random_device()()) << 32) | std::random_device()();
+	static std::atomic<unsigned long long> s_counter(0);
+#ifdef _WIN32
+	unsigned long long pid = _getpid();
+#else
+	unsigned long long pid = getpid();
+#endif
+	unsigned long long thread = std::hash<std::thread::id>()(std::this_thread::get_id());
+	char suffix[96];
+	snprintf(suffix, sizeof(suffix), ".%llu.%016llx.%llx.%llu.tmp", pid, s_token, thread, s_counter++);
+	return suffix;
+}
+
+// replace the entry in to by from in a single step (a reader sees the old entry or the new one)
+static bool RenameEntry(const std::string& from, const std::string& to)
+{
+#ifdef _WIN32
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+CacheSink::CacheSink(OutputSink& output, const SectionCache& cache, uint64_t key)
+: m_output(output)
+, m_path(cache.GetPath(key))
+, m_tmpPath(m_path + UniqueTmpSuffix())
+// x: the entry is never opened over a file of another writer
+, m_entry(FileSink::Open(m_tmpPath.c_str(), "wbx"))
+, m_isEntryValid(nullptr != m_entry)
+{
+}
+
+CacheSink::~CacheSink()
+{
+	if (nullptr != m_entry)
+	{
+		fclose(m_entry);
+		remove(m_tmpPath.c_str());
+	}
+}
+
+bool CacheSink::Commit()
+{
+	if (nullptr == m_entry)
+	{
+		return false;
+	}
+
+	// the entry gets its name only when it is complete so a partial entry is never read.
+	// writers of the same key write the same section so the last rename wins
+	m_isEntryValid &= fclose(m_entry) == 0;
+	m_entry = nullptr;
+	if (!m_isEntryValid || !RenameEntry(m_tmpPath, m_path))
+	{
+		remove(m_tmpPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+bool CacheSink::WriteIMP(const char *data, size_t size)
+{
+	// a failure of the entry doesn't fail the output
+	if (m_isEntryValid)
+	{
+		m_isEntryValid = fwrite(data, 1, size, m_entry) == size;
+	}
+
+	return m_output.Write(data, size);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "OutputSink.h"
+
+//	64 bit hash (fnv-1a) of the inputs of a section. equal inputs added in the same order give the same key
+class ContentHash
+{
+public:
+	ContentHash() : m_hash(s_offsetBasis) {}
+
+	void Add(const void *data, size_t size);
+	void Add(uint64_t value) { Add(&value, sizeof(value)); }
+	void Add(double value) { Add(&value, sizeof(value)); }
+	void Add(const std::string& str) { Add(static_cast<uint64_t>(str.size())); Add(str.data(), str.size()); }
+
+	uint64_t GetKey() const { return m_hash; }
+
+private:
+	static const uint64_t s_offsetBasis = 14695981039346656037ULL;
+	static const uint64_t s_prime = 1099511628211ULL;
+
+	uint64_t m_hash;
+};
+
+//	content-addressed cache of sections of the pomdp text in a directory (a file for each key).
+//	the key of a section is the hash of exactly the inputs the section depends on, so a section
+//	is calculated again only when one of its inputs was changed
+class SectionCache
+{
+public:
+	enum ReadStatus
+	{
+		READ_MISSING = 0,
+		READ_DONE,
+		// part of the section may be written so the section can't be calculated instead
+		READ_FAILED,
+	};
+
+	// the directory must exist
+	explicit SectionCache(const std::string& directory);
+	~SectionCache() = default;
+
+	// write the section of key to sink. returns READ_MISSING if the section is not in the cache
+	ReadStatus Read(uint64_t key, OutputSink& sink) const;
+
+	// path of the file of key
+	std::string GetPath(uint64_t key) const;
+
+private:
+	std::string m_directory;
+};
+
+//	sink that writes the section to the output and to a new entry of the cache.
+//	the entry is added to the cache only by Commit (an entry that was not committed is removed)
+class CacheSink : public OutputSink
+{
+public:
+	CacheSink(OutputSink& output, const SectionCache& cache, uint64_t key);
+	~CacheSink();
+	CacheSink(const CacheSink&) = delete;
+	CacheSink& operator=(const CacheSink&) = delete;
+
+	bool Flush() override { return m_output.Flush(); }
+	// keep the entry in the cache. returns false if the entry could not be written (the output is not affected)
+	bool Commit();
+
+protected:
+	bool WriteIMP(const char *data, size_t size) override;
+
+private:
+	OutputSink& m_output;
+	std::string m_path;
+	std::string m_tmpPath;
+	FILE *m_entry;
+	bool m_isEntryValid;
+};
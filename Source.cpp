@@ -3,12 +3,26 @@
 #include "Move_Properties.h"
 #include "Movable_Obj.h"
 #include "Attack_Obj.h"
+#include "BatchGenerator.h"
+#include "PerseusSolver.h"
 #include <random>
 #include <type_traits>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
 #include <map>
 
-int main()
+//	usage: pomdp_writer [scenarios file] [threads]
+//	without a scenarios file the example scenario is written to nxnGrid.POMDP.
+//	each line of the scenarios file is a scenario (empty lines and lines starting with # are skipped).
+//	a file that ends with .gz is written compressed with the index of its blocks in <file>.gz.idx.
+//	with solve (discount below 1) the model is also solved for at most the seconds and the alpha vectors are written to <file>.alpha:
+//	<file> grid <size> target <idx> self <x> <y> <std> <stay> <attack range> <pHit> <observation range> <pObservation>
+//		enemy <x> <y> <std> <stay> <range> <pHit> [ninv <x> <y> <std> <stay>]... [shelter <x> <y>]... [discount <d>] [binary]
+//		[solve <seconds>]
+
+static void ExampleScenario(std::vector<BatchScenario>& scenarios)
 {
 	Point locSelf(1, 1, 0.5);
 	Move_Properties mSelf(0.2);
@@ -18,36 +32,137 @@ int main()
 	Move_Properties mEnemy(0.6);
 	Attack_Obj enemy(locEnemy, mEnemy, 1, 0.2);
 
-	POMDP_Writer pomdp(3, self, enemy);
+	scenarios.emplace_back(3, self, enemy, 8, "nxnGrid.POMDP");
 
 	Point x1(1, 2);
 	Move_Properties p1(0.8);
 	Movable_Obj N1(x1, p1);
-	pomdp.AddObj(N1);
+	scenarios.back().m_nonInvolved.push_back(N1);
 
 	//Point x2(1, 2);
 	//Move_Properties p2(0.2);
 	//Movable_Obj N2(x2, p2);
-	//pomdp.AddObj(N2);
+	//scenarios.back().m_nonInvolved.push_back(N2);
 
 	Point x3(0, 2);
 	ObjInGrid s1(x3);
-	pomdp.AddObj(s1);
+	scenarios.back().m_shelters.push_back(s1);
+}
 
-	remove("nxnGrid.POMDP");
+// read a scenario from a line of the scenarios file. returns false if the line is not valid
+static bool ReadScenario(const std::string& line, std::vector<BatchScenario>& scenarios)
+{
+	std::istringstream in(line);
+	std::string fileName, word;
+	size_t gridSize = 0, idxTarget = 0;
+	size_t x, y, attackRange, rangeObs, range;
+	double dev, stay, pHit, pObs, discount = 0.95, solveSeconds = 0.0;
+	std::unique_ptr<Self_Obj> self;
+	std::unique_ptr<Attack_Obj> enemy;
+	std::vector<Movable_Obj> nonInvolved;
+	std::vector<ObjInGrid> shelters;
+	bool isBinary = false;
+
+	in >> fileName;
+	while (in >> word)
+	{
+		if ("grid" == word && in >> gridSize) {}
+		else if ("target" == word && in >> idxTarget) {}
+		else if ("self" == word && in >> x >> y >> dev >> stay >> attackRange >> pHit >> rangeObs >> pObs)
+		{
+			Point location(x, y, dev);
+			Move_Properties movement(stay);
+			self.reset(new Self_Obj(location, movement, attackRange, pHit, rangeObs, pObs));
+		}
+		else if ("enemy" == word && in >> x >> y >> dev >> stay >> range >> pHit)
+		{
+			Point location(x, y, dev);
+			Move_Properties movement(stay);
+			enemy.reset(new Attack_Obj(location, movement, range, pHit));
+		}
+		else if ("ninv" == word && in >> x >> y >> dev >> stay)
+		{
+			Point location(x, y, dev);
+			Move_Properties movement(stay);
+			nonInvolved.emplace_back(location, movement);
+		}
+		else if ("shelter" == word && in >> x >> y)
+		{
+			Point location(x, y);
+			shelters.emplace_back(location);
+		}
+		else if ("discount" == word && in >> discount) {}
+		else if ("solve" == word && in >> solveSeconds) {}
+		else if ("binary" == word)
+		{
+			isBinary = true;
+		}
+		else
+		{
+			return false;
+		}
+	}
 
-	FILE *fptr;
-	auto err = fopen_s(&fptr, "nxnGrid.POMDP", "w");
-	if (0 != err)
+	if (fileName.empty() || 0 == gridSize || nullptr == self || nullptr == enemy || !StateIndexer::IsValid(gridSize, 2 + nonInvolved.size()))
+	{
+		return false;
+	}
+	// the solver converges only with discount below 1
+	if (solveSeconds > 0 && !PerseusSolver<float>::IsValidDiscount(discount))
 	{
-		std::cout << "ERROR OPEN\n";
+		return false;
 	}
 
-	pomdp.SaveInFormat(fptr, 8);
-	fclose(fptr);
+	scenarios.emplace_back(gridSize, *self, *enemy, idxTarget, fileName);
+	scenarios.back().m_nonInvolved = nonInvolved;
+	scenarios.back().m_shelters = shelters;
+	scenarios.back().m_discount = discount;
+	scenarios.back().m_isBinary = isBinary;
+	scenarios.back().m_solveSeconds = solveSeconds;
+	return true;
+}
 
+int main(int argc, char **argv)
+{
+	std::vector<BatchScenario> scenarios;
+	if (argc < 2)
+	{
+		ExampleScenario(scenarios);
+	}
+	else
+	{
+		std::ifstream file(argv[1]);
+		if (!file)
+		{
+			std::cerr << "ERROR OPEN " << argv[1] << "\n";
+			return 1;
+		}
+
+		std::string line;
+		for (size_t lineNum = 1; std::getline(file, line); ++lineNum)
+		{
+			if (line.find_first_not_of(" \t\r") == std::string::npos || '#' == line[line.find_first_not_of(" \t")])
+			{
+				continue;
+			}
+			if (!ReadScenario(line, scenarios))
+			{
+				std::cerr << "invalid scenario in line " << lineNum << "\n";
+				return 1;
+			}
+		}
+	}
+
+	size_t threads = argc > 2 ? std::stoul(argv[2]) : std::thread::hardware_concurrency();
+	BatchGenerator generator(threads);
+	std::vector<size_t> bytesWritten = generator.Generate(scenarios);
+
+	int failed = 0;
+	for (size_t i = 0; i < scenarios.size(); ++i)
+	{
+		std::cout << scenarios[i].m_fileName << " " << bytesWritten[i] << " bytes\n";
+		failed += 0 == bytesWritten[i];
+	}
 
-	char c;
-	std::cout << "press any key";
-	std::cin >> c;
+	return failed > 0 ? 1 : 0;
 }
@@ -0,0 +1,149 @@
+#include "SparseModelBuilder.h"
+
+#include <algorithm>
+
+SparseModelBuilder::SparseModelBuilder(size_t numActions, size_t numStates)
+: m_numStates(numStates)
+, m_transitions(numActions + 1)
+, m_observations()
+, m_isSorted(false)
+{
+}
+
+void SparseModelBuilder::AddTransition(int action, size_t state, size_t endState, double p)
+{
+	m_transitions[action + 1].push_back(Entry{ static_cast<uint32_t>(state), static_cast<uint32_t>(endState), p });
+	m_isSorted = false;
+}
+
+void SparseModelBuilder::AddObservation(size_t endState, size_t observation, double p)
+{
+	m_observations.push_back(Entry{ static_cast<uint32_t>(endState), static_cast<uint32_t>(observation), p });
+	m_isSorted = false;
+}
+
+void SparseModelBuilder::Append(SparseModelBuilder& other)
+{
+	for (size_t i = 0; i < m_transitions.size(); ++i)
+	{
+		m_transitions[i].insert(m_transitions[i].end(), other.m_transitions[i].begin(), other.m_transitions[i].end());
+		other.m_transitions[i].clear();
+	}
+	m_observations.insert(m_observations.end(), other.m_observations.begin(), other.m_observations.end());
+	other.m_observations.clear();
+	m_isSorted = false;
+}
+
+void SparseModelBuilder::AppendPermuted(const SparseModelBuilder& other, const uint32_t *stateMap, const int *actionMap)
+{
+	for (size_t i = 0; i < m_transitions.size(); ++i)
+	{
+		std::vector<Entry>& entries = m_transitions[actionMap[i] + 1];
+		for (const Entry& entry : other.m_transitions[i])
+		{
+			entries.push_back(Entry{ stateMap[entry.m_row], stateMap[entry.m_col], entry.m_value });
+		}
+	}
+	m_isSorted = false;
+}
+
+void SparseModelBuilder::Sort()
+{
+	if (m_isSorted)
+	{
+		return;
+	}
+
+	auto less = [](const Entry& a, const Entry& b) { return a.m_row < b.m_row || (a.m_row == b.m_row && a.m_col < b.m_col); };
+	for (auto & entries : m_transitions)
+	{
+		std::stable_sort(entries.begin(), entries.end(), less);
+	}
+	// the observations are usually added in order (the rows of the states one after the other)
+	if (!std::is_sorted(m_observations.begin(), m_observations.end(), less))
+	{
+		std::stable_sort(m_observations.begin(), m_observations.end(), less);
+	}
+	m_isSorted = true;
+}
+
+CsrMatrix SparseModelBuilder::BuildTransitions(size_t action)
+{
+	Sort();
+	const std::vector<Entry>& all = m_transitions[0];
+	const std::vector<Entry>& specific = m_transitions[action + 1];
+
+	CsrMatrix matrix;
+	matrix.m_numCols = m_numStates;
+	matrix.m_rowOffsets.reserve(m_numStates + 1);
+	matrix.m_rowOffsets.push_back(0);
+
+	// run on the rows of both lists together. a row of the action replaces the row of all actions
+	size_t iAll = 0;
+	size_t iSpecific = 0;
+	for (uint32_t row = 0; row < m_numStates; ++row)
+	{
+		size_t endAll = iAll;
+		for (; endAll < all.size() && all[endAll].m_row == row; ++endAll);
+		size_t endSpecific = iSpecific;
+		for (; endSpecific < specific.size() && specific[endSpecific].m_row == row; ++endSpecific);
+
+		if (endSpecific > iSpecific)
+		{
+			AddRow(matrix, &specific[0] + iSpecific, &specific[0] + endSpecific);
+		}
+		else if (endAll > iAll)
+		{
+			AddRow(matrix, &all[0] + iAll, &all[0] + endAll);
+		}
+		matrix.m_rowOffsets.push_back(matrix.m_values.size());
+
+		iAll = endAll;
+		iSpecific = endSpecific;
+	}
+
+	return matrix;
+}
+
+CsrMatrix SparseModelBuilder::BuildObservations(size_t numObservations)
+{
+	Sort();
+	CsrMatrix matrix;
+	matrix.m_numCols = numObservations;
+	matrix.m_rowOffsets.reserve(m_numStates + 1);
+	matrix.m_rowOffsets.push_back(0);
+	matrix.m_columns.reserve(m_observations.size());
+	matrix.m_values.reserve(m_observations.size());
+
+	size_t i = 0;
+	for (uint32_t row = 0; row < m_numStates; ++row)
+	{
+		size_t end = i;
+		for (; end < m_observations.size() && m_observations[end].m_row == row; ++end);
+		if (end > i)
+		{
+			AddRow(matrix, &m_observations[0] + i, &m_observations[0] + end);
+		}
+		matrix.m_rowOffsets.push_back(matrix.m_values.size());
+		i = end;
+	}
+
+	return matrix;
+}
+
+void SparseModelBuilder::AddRow(CsrMatrix& matrix, const Entry *begin, const Entry *end)
+{
+	for (const Entry *itr = begin; itr != end; ++itr)
+	{
+		// the entries are sorted by column so a repeated entry is the previous entry of the row
+		if (itr != begin && itr->m_col == matrix.m_columns.back())
+		{
+			matrix.m_values.back() += itr->m_value;
+		}
+		else
+		{
+			matrix.m_columns.push_back(itr->m_col);
+			matrix.m_values.push_back(itr->m_value);
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// sparse matrix in compressed sparse row format (the columns of each row are sorted). the values are float or double
+template <typename T>
+struct CsrMatrixT
+{
+	size_t m_numCols = 0;
+	// row i is [m_rowOffsets[i], m_rowOffsets[i + 1]) in m_columns and m_values
+	std::vector<uint64_t> m_rowOffsets;
+	std::vector<uint32_t> m_columns;
+	std::vector<T> m_values;
+
+	size_t GetNumRows() const { return m_rowOffsets.empty() ? 0 : m_rowOffsets.size() - 1; }
+	size_t GetNumNonZeros() const { return m_values.size(); }
+};
+
+using CsrMatrix = CsrMatrixT<double>;
+
+//	collects the transitions of each action and the observations while the model is calculated and builds the sparse matrices.
+//	the rows of a specific action replace the rows of all actions (s_allActions) with the same start-state
+//	and repeated entries in a row are summed.
+class SparseModelBuilder
+{
+public:
+	static const int s_allActions = -1;
+
+	SparseModelBuilder(size_t numActions, size_t numStates);
+
+	size_t GetNumActions() const { return m_transitions.size() - 1; }
+	size_t GetNumStates() const { return m_numStates; }
+
+	void AddTransition(int action, size_t state, size_t endState, double p);
+	// probability of observation in end-state (the same for all actions)
+	void AddObservation(size_t endState, size_t observation, double p);
+
+	// move the entries of other to the end of the entries of this builder
+	void Append(SparseModelBuilder& other);
+	// add the entries of other with the states and the actions replaced (stateMap[state], actionMap[action + 1])
+	void AppendPermuted(const SparseModelBuilder& other, const uint32_t *stateMap, const int *actionMap);
+
+	// matrix of numStates x numStates
+	CsrMatrix BuildTransitions(size_t action);
+	// matrix of numStates x numObservations
+	CsrMatrix BuildObservations(size_t numObservations);
+
+private:
+	struct Entry
+	{
+		uint32_t m_row;
+		uint32_t m_col;
+		double m_value;
+	};
+
+	size_t m_numStates;
+	// entries of all actions in idx 0 and of each action in idx action + 1
+	std::vector<std::vector<Entry>> m_transitions;
+	std::vector<Entry> m_observations;
+	bool m_isSorted;
+
+	// sort the entries of each action by row and column (keeping the order of repeated entries)
+	void Sort();
+	// add the entries [begin, end) of a single row (sorted by column) to the matrix summing repeated entries
+	static void AddRow(CsrMatrix& matrix, const Entry *begin, const Entry *end);
+};
@@ -0,0 +1,108 @@
+#include "StartDistribution.h"
+
+StartDistribution::StartDistribution(const StateIndexer& indexer, size_t numCells, const double *pMat, double epsilon)
+: m_indexer(indexer)
+, m_numCells(numCells)
+, m_pMat(pMat)
+, m_epsilon(epsilon)
+, m_entries()
+, m_locations(indexer.GetNumObjects())
+, m_isTaken(numCells, false)
+, m_lastLevel(numCells)
+{
+	CalcLevel(0, 1.0, 0);
+
+	if (m_epsilon <= 0.0)
+	{
+		return;
+	}
+
+	// normalize the entries that were left to the sum of the full distribution
+	double sum = 0.0;
+	for (const auto& entry : m_entries)
+	{
+		sum += entry.m_p;
+	}
+	if (sum > 0.0)
+	{
+		for (auto& entry : m_entries)
+		{
+			entry.m_p /= sum;
+		}
+	}
+}
+
+void StartDistribution::CalcLevel(size_t level, double pPrefix, size_t firstIdx)
+{
+	if (level == m_locations.size() - 1)
+	{
+		CalcLastLevel(pPrefix, firstIdx);
+		return;
+	}
+
+	const double *pObj = m_pMat + level * m_numCells;
+	double share = RepetitionShare(level);
+	size_t weight = m_indexer.LiveWeight(level);
+
+	// the digit of a location in the idx is its order among the free locations
+	size_t digit = 0;
+	for (size_t location = 0; location < m_numCells; ++location)
+	{
+		if (m_isTaken[location])
+		{
+			continue;
+		}
+
+		double p = pPrefix * (pObj[location] + share);
+		if (p > 0.0 && p >= m_epsilon)
+		{
+			m_locations[level] = static_cast<int>(location);
+			m_isTaken[location] = true;
+			CalcLevel(level + 1, p, firstIdx + digit * weight);
+			m_isTaken[location] = false;
+		}
+		++digit;
+	}
+}
+
+void StartDistribution::CalcLastLevel(double pPrefix, size_t firstIdx)
+{
+	size_t level = m_locations.size() - 1;
+	const double *pObj = m_pMat + level * m_numCells;
+	double share = RepetitionShare(level);
+
+	// probability of all locations at once and then take the free locations
+	double *pLast = &m_lastLevel[0];
+	for (size_t location = 0; location < m_numCells; ++location)
+	{
+		pLast[location] = pPrefix * (pObj[location] + share);
+	}
+
+	size_t idx = firstIdx;
+	for (size_t location = 0; location < m_numCells; ++location)
+	{
+		if (m_isTaken[location])
+		{
+			continue;
+		}
+
+		if (pLast[location] > 0.0 && pLast[location] >= m_epsilon)
+		{
+			m_entries.push_back(Entry{ idx, pLast[location] });
+		}
+		++idx;
+	}
+}
+
+double StartDistribution::RepetitionShare(size_t level) const
+{
+	// the probability of the taken locations is divided equally between the free locations
+	const double *pObj = m_pMat + level * m_numCells;
+	double pToDivide = 0;
+	for (size_t i = 0; i < level; ++i)
+	{
+		pToDivide += pObj[m_locations[i]];
+	}
+
+	return pToDivide / (m_numCells - level);
+}
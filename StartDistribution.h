@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "StateIndexer.h"
+
+//	sparse start distribution of the live states from the location probabilities of each object.
+//	the probability of a state is the multiplication of the probability of each object location, where an object
+//	gets an equal share of its probability in the locations taken by the previous objects (the locations can't repeat).
+//	the states are visited in the order of their idx as a tree of the object locations, and a subtree is skipped when
+//	the probability of its prefix is below epsilon (the probability of each object location is at most 1)
+class StartDistribution
+{
+public:
+	struct Entry
+	{
+		size_t m_idx;
+		double m_p;
+	};
+
+	// pMat is numCells probabilities of the location of each object (in the order of the objects in the state).
+	// entries below epsilon are dropped and the rest are normalized to the same sum (nothing is dropped with epsilon 0)
+	StartDistribution(const StateIndexer& indexer, size_t numCells, const double *pMat, double epsilon = 0.0);
+	~StartDistribution() = default;
+
+	// non-zero entries in the order of the idx
+	const std::vector<Entry>& GetEntries() const { return m_entries; }
+
+private:
+	const StateIndexer& m_indexer;
+	size_t m_numCells;
+	const double *m_pMat;
+	double m_epsilon;
+	std::vector<Entry> m_entries;
+
+	// location of each object in the current prefix and a flag for each taken location
+	std::vector<int> m_locations;
+	std::vector<bool> m_isTaken;
+	// probability of the last object in each location (scratch of the last level)
+	std::vector<double> m_lastLevel;
+
+	void CalcLevel(size_t level, double pPrefix, size_t firstIdx);
+	void CalcLastLevel(double pPrefix, size_t firstIdx);
+	// the share of object level from the locations taken by the previous objects
+	double RepetitionShare(size_t level) const;
+};
@@ -0,0 +1,146 @@
+#include "StateIndexer.h"
+
+#include <limits>
+
+const size_t StateIndexer::s_maxObjects;
+
+// calculate the weights of each location in the rank (the number of permutations of the rest of the locations)
+static void CalcWeights(std::vector<size_t>& weights, size_t numCells, size_t numLocations)
+{
+	weights.assign(numLocations, 1);
+	for (int i = static_cast<int>(numLocations) - 2; i >= 0; --i)
+	{
+		weights[i] = weights[i + 1] * (numCells - 1 - i);
+	}
+}
+
+// number of permutations of k of n locations. returns false if it overflows size_t
+static bool Permutations(size_t n, size_t k, size_t& result)
+{
+	result = 1;
+	for (size_t i = 0; i < k; ++i)
+	{
+		if (result > std::numeric_limits<size_t>::max() / (n - i))
+		{
+			return false;
+		}
+		result *= n - i;
+	}
+
+	return true;
+}
+
+StateIndexer::StateIndexer(size_t gridSize, size_t numObjects)
+: m_isValid(IsValid(gridSize, numObjects))
+, m_numCells(gridSize * gridSize)
+, m_numObjects(numObjects)
+, m_numLive(0)
+, m_numDead(0)
+, m_liveWeights(1, 1)
+, m_deadWeights(1, 1)
+{
+	// the caller reports the objects that are not valid (the indexer has only win and loss)
+	if (!m_isValid)
+	{
+		return;
+	}
+
+	CalcWeights(m_liveWeights, m_numCells, numObjects);
+	CalcWeights(m_deadWeights, m_numCells, numObjects - 1);
+
+	m_numLive = m_numCells * m_liveWeights[0];
+	m_numDead = m_numCells * m_deadWeights[0];
+}
+
+bool StateIndexer::IsValid(size_t gridSize, size_t numObjects)
+{
+	if (numObjects < 2 || numObjects > s_maxObjects || gridSize > std::numeric_limits<size_t>::max() / gridSize)
+	{
+		return false;
+	}
+
+	// live and dead states with win and loss (the dead states are fewer than the live states)
+	size_t numCells = gridSize * gridSize;
+	size_t numLive, numDead;
+	return numObjects <= numCells && Permutations(numCells, numObjects, numLive) && Permutations(numCells, numObjects - 1, numDead)
+		&& numLive <= std::numeric_limits<size_t>::max() - numDead - 2;
+}
+
+size_t StateIndexer::Rank(const int *stateVec) const
+{
+	if (stateVec[ENEMY_IDX] != DEAD_ENEMY)
+	{
+		return RankLocations(stateVec, m_numObjects, m_liveWeights);
+	}
+
+	// rank the state without the enemy
+	int locations[s_maxObjects];
+	locations[0] = stateVec[0];
+	for (size_t i = 2; i < m_numObjects; ++i)
+	{
+		locations[i - 1] = stateVec[i];
+	}
+
+	return m_numLive + RankLocations(locations, m_numObjects - 1, m_deadWeights);
+}
+
+void StateIndexer::Unrank(size_t idx, int *stateVec) const
+{
+	if (idx < m_numLive)
+	{
+		UnrankLocations(idx, stateVec, m_numObjects, m_liveWeights);
+		return;
+	}
+
+	// unrank the state without the enemy and insert the dead enemy
+	int locations[s_maxObjects] = {};
+	UnrankLocations(idx - m_numLive, locations, m_numObjects - 1, m_deadWeights);
+	stateVec[0] = locations[0];
+	stateVec[ENEMY_IDX] = DEAD_ENEMY;
+	for (size_t i = 2; i < m_numObjects; ++i)
+	{
+		stateVec[i] = locations[i - 1];
+	}
+}
+
+size_t StateIndexer::RankLocations(const int *locations, size_t numLocations, const std::vector<size_t>& weights) const
+{
+	size_t rank = 0;
+	for (size_t i = 0; i < numLocations; ++i)
+	{
+		// the digit of the location is its location among the locations that were not taken by previous objects
+		int digit = locations[i];
+		for (size_t j = 0; j < i; ++j)
+		{
+			digit -= locations[j] < locations[i];
+		}
+		rank += digit * weights[i];
+	}
+
+	return rank;
+}
+
+void StateIndexer::UnrankLocations(size_t rank, int *locations, size_t numLocations, const std::vector<size_t>& weights) const
+{
+	// previous locations sorted to skip taken locations
+	int sorted[s_maxObjects];
+	for (size_t i = 0; i < numLocations; ++i)
+	{
+		int location = static_cast<int>(rank / weights[i]);
+		rank %= weights[i];
+
+		// skip on taken locations (sorted runs from the lowest taken location)
+		size_t insert = 0;
+		for (; insert < i && sorted[insert] <= location; ++insert)
+		{
+			++location;
+		}
+		locations[i] = location;
+
+		for (size_t j = i; j > insert; --j)
+		{
+			sorted[j] = sorted[j - 1];
+		}
+		sorted[insert] = location;
+	}
+}
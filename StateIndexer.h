@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// value in stateVec for dead enemy
+static const int DEAD_ENEMY = -2;
+// idx of enemy in the stateVec
+static const int ENEMY_IDX = 1;
+
+//	dense integer indexing of the pomdp states (rank / unrank).
+//	the idx order is the order of appearance of the states in the pomdp file (CalcS_ORec):
+//	first all states with live enemy, then all states with dead enemy, and at last Win and Loss.
+//	in each part the states are ordered lexicographicaly by the location of the objects (self, enemy, non-involved..)
+//	so all the states of a single robot location are a continuous block of idx.
+class StateIndexer
+{
+public:
+	// most objects in a state (the robot, the enemy and the non-involved)
+	static const size_t s_maxObjects = 32;
+
+	// an indexer of objects that are not valid (see IsValid) has no states
+	StateIndexer(size_t gridSize, size_t numObjects);
+	~StateIndexer() = default;
+
+	// 2 to s_maxObjects objects in different cells of the grid and the number of states fits in size_t
+	static bool IsValid(size_t gridSize, size_t numObjects);
+	// the objects of the indexer are valid (otherwise there are only win and loss and nothing can be ranked)
+	bool IsValid() const { return m_isValid; }
+
+	size_t GetNumObjects() const { return m_numObjects; }
+
+	size_t NumLive() const { return m_numLive; }
+	size_t NumDead() const { return m_numDead; }
+	// number of states including win and loss
+	size_t NumStates() const { return m_numLive + m_numDead + 2; }
+	size_t WinIdx() const { return m_numLive + m_numDead; }
+	size_t LossIdx() const { return m_numLive + m_numDead + 1; }
+	bool IsDead(size_t idx) const { return idx >= m_numLive && idx < m_numLive + m_numDead; }
+	// location of the robot in a live or dead state
+	int GetSelf(size_t idx) const { return static_cast<int>(idx < m_numLive ? idx / LiveBlock() : (idx - m_numLive) / DeadBlock()); }
+
+	// number of live/dead states with the same robot location
+	size_t LiveBlock() const { return m_liveWeights[0]; }
+	size_t DeadBlock() const { return m_deadWeights[0]; }
+	// first idx of the live/dead states with robot location self
+	size_t FirstLive(int self) const { return self * LiveBlock(); }
+	size_t FirstDead(int self) const { return m_numLive + self * DeadBlock(); }
+	// weight of the location of object i in the idx of a live state
+	size_t LiveWeight(size_t i) const { return m_liveWeights[i]; }
+
+	// translate a legal state (no repetitions, DEAD_ENEMY allowed in the enemy idx) to its idx
+	size_t Rank(const int *stateVec) const;
+	// translate idx of live or dead state to the locations of the objects
+	void Unrank(size_t idx, int *stateVec) const;
+
+private:
+	bool m_isValid;
+	size_t m_numCells;
+	size_t m_numObjects;
+	size_t m_numLive;
+	size_t m_numDead;
+
+	// number of states in the suffix after each object location (weight of the object in the rank)
+	std::vector<size_t> m_liveWeights;
+	std::vector<size_t> m_deadWeights;
+
+	// rank of permutation of locations (without repetitions)
+	size_t RankLocations(const int *locations, size_t numLocations, const std::vector<size_t>& weights) const;
+	void UnrankLocations(size_t rank, int *locations, size_t numLocations, const std::vector<size_t>& weights) const;
+};
+
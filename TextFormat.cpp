@@ -0,0 +1,64 @@
+#include "TextFormat.h"
+
+#include <charconv>
+
+#include "StateIndexer.h"
+
+// max digits of a double (more digits don't change the value)
+static const int s_maxPrecision = 17;
+
+const int TextFormat::s_shortest;
+const size_t TextFormat::s_maxNumber;
+const size_t TextFormat::s_maxInteger;
+
+char *TextFormat::Integer(char *first, char *last, long long value)
+{
+	return std::to_chars(first, last, value).ptr;
+}
+
+char *TextFormat::Fixed(char *first, char *last, double value, int precision)
+{
+	if (s_shortest == precision)
+	{
+		return std::to_chars(first, last, value, std::chars_format::fixed).ptr;
+	}
+
+	return std::to_chars(first, last, value, std::chars_format::fixed, precision < s_maxPrecision ? precision : s_maxPrecision).ptr;
+}
+
+char *TextFormat::General(char *first, char *last, double value, int precision)
+{
+	if (s_shortest == precision)
+	{
+		return std::to_chars(first, last, value).ptr;
+	}
+
+	return std::to_chars(first, last, value, std::chars_format::general, precision < s_maxPrecision ? precision : s_maxPrecision).ptr;
+}
+
+char *TextFormat::StateName(char *first, char *last, const int *stateVec, size_t numObjects, const char *type)
+{
+	for (; *type != '\0'; ++type)
+	{
+		*first++ = *type;
+	}
+
+	for (size_t i = 0; i < numObjects; ++i)
+	{
+		if (i > 0)
+		{
+			*first++ = 'x';
+		}
+
+		if (stateVec[i] == DEAD_ENEMY)
+		{
+			*first++ = 'D';
+		}
+		else
+		{
+			first = std::to_chars(first, last, stateVec[i]).ptr;
+		}
+	}
+
+	return first;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+//	allocation-free formatting of the numbers and names of the pomdp text (std::to_chars).
+//	each function writes to [first, last) and returns the end of the text written.
+//	last - first must be at least s_maxNumber for a double, s_maxInteger for an integer
+//	and the length of the type and s_maxInteger for each object for a state name
+class TextFormat
+{
+public:
+	// precision of the shortest text that reads back to the same double
+	static const int s_shortest = -1;
+	// max characters of a single number (fixed double with max precision)
+	static const size_t s_maxNumber = 350;
+	// max characters of an integer (with its separator in a state name)
+	static const size_t s_maxInteger = 24;
+
+	static char *Integer(char *first, char *last, long long value);
+	// precision digits after the point ("%.<precision>f")
+	static char *Fixed(char *first, char *last, double value, int precision);
+	// precision significant digits ("%.<precision>g")
+	static char *General(char *first, char *last, double value, int precision);
+	// name of state: type and the locations of the objects separated by x (D for dead enemy)
+	static char *StateName(char *first, char *last, const int *stateVec, size_t numObjects, const char *type);
+};
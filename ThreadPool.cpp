@@ -0,0 +1,59 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t numThreads)
+: m_workers()
+, m_tasks()
+, m_stop(false)
+{
+	for (size_t i = 0; i < numThreads; ++i)
+	{
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_cond.notify_all();
+
+	for (auto &worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> task)
+{
+	std::packaged_task<void()> packed(std::move(task));
+	std::future<void> result = packed.get_future();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.emplace(std::move(packed));
+	}
+	m_cond.notify_one();
+
+	return result;
+}
+
+void ThreadPool::WorkerLoop()
+{
+	while (true)
+	{
+		std::packaged_task<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cond.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+			// stop only when there are no tasks left
+			if (m_tasks.empty())
+			{
+				return;
+			}
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+		}
+		task();
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+
+//	fixed size pool of worker threads. tasks are run in the order they were submitted
+class ThreadPool
+{
+public:
+	explicit ThreadPool(size_t numThreads);
+	// finish all submitted tasks and join the workers
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// submit task to the pool. the future is ready when the task is finished
+	std::future<void> Submit(std::function<void()> task);
+
+	size_t GetNumThreads() const { return m_workers.size(); }
+
+private:
+	std::vector<std::thread> m_workers;
+	std::queue<std::packaged_task<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	bool m_stop;
+
+	void WorkerLoop();
+};